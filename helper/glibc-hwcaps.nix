@@ -0,0 +1,28 @@
+# Shared libraries for several Zen generations in one closure, via glibc-hwcaps.
+# See documentation at ../docu/zen-optimized-pkgs.adoc
+#
+# The dynamic loader (glibc >= 2.33) looks for a library in <dir>/glibc-hwcaps/<level>/ before <dir> itself,
+# for every x86-64 micro-architecture level the CPU supports, best first. glibc only knows these levels, not
+# znverN: Zen 2 and 3 are x86-64-v3, Zen 4 and 5 x86-64-v4 (AVX-512).
+{ lib }:
+rec {
+    levelNumberOfZen = amdZenVersion: if amdZenVersion >= 4 then 4 else 3;
+    levelOfZen = amdZenVersion: "x86-64-v${toString (levelNumberOfZen amdZenVersion)}";
+
+    # `package` with the shared libraries of each variant ({ <level> = <the package built for that level>; })
+    # linked into lib/glibc-hwcaps/<level>/ of its library output, under the same names (the soname links included)
+    withHwcaps = variants: package:
+        if variants == {} then package else package.overrideAttrs (old: {
+            postFixup = (old.postFixup or "") + ''
+                hwcapsLibDir="''${!outputLib}/lib"
+            '' + lib.concatStrings (lib.mapAttrsToList (level: variant: ''
+                mkdir -p "$hwcapsLibDir/glibc-hwcaps/${level}"
+                for so in "$hwcapsLibDir"/*.so "$hwcapsLibDir"/*.so.*; do
+                    name=$(basename "$so")
+                    if [ -e "${lib.getLib variant}/lib/$name" ]; then
+                        ln -s "${lib.getLib variant}/lib/$name" "$hwcapsLibDir/glibc-hwcaps/${level}/$name"
+                    fi
+                done
+            '') variants);
+        });
+}
@@ -0,0 +1,73 @@
+/* zen-target-clones.h
+ *
+ * On the include path of the withTargetClones stdenv (see my-stenv-adapter.nix), which also defines
+ *   ZEN_TARGET_CLONES          the target_clones attribute for the functions to multi-version
+ *   ZEN_TARGET_CLONE_ARCHS     the clones as a string, e.g. "znver5,znver4,znver3"
+ *   ZEN_TARGET_CLONE_ZNVER<N>  for each of them
+ * Programs include it only when built that way:
+ *   #ifdef ZEN_TARGET_CLONE_ARCHS
+ *   #include <zen-target-clones.h>
+ *   #else
+ *   #define ZEN_TARGET_CLONES
+ *   #endif
+ *
+ * zen_target_clone_selected() reports the clone the ifunc resolvers pick on this CPU. It doesn't repeat GCC's
+ * dispatch rules: a probe function is cloned like the marked code, its resolver (generated by GCC, the same
+ * checks the loader ran for every marked function) is called and the clone it returns is looked up by its
+ * symbol name. Needs GCC's clone naming (<function>.arch_<cpu>, <function>.default, <function>.resolver).
+ */
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+ZEN_TARGET_CLONES __attribute__((used, noinline))
+static int zen_target_clone_probe(void) { return 0; }
+
+/* The probe's resolver and clones, by their assembler names. Weak: a clone GCC didn't emit is NULL, not a link
+ * error. GCC gives the definitions default visibility (the .weak makes them global), so they are marked hidden
+ * explicitly: then the references are resolved inside the object, without a GOT, also in shared libraries. */
+#define ZEN_TARGET_CLONE_PROBE_(type, name, suffix) \
+    extern type name(void) __asm__("zen_target_clone_probe." suffix) __attribute__((weak)); \
+    __asm__(".hidden zen_target_clone_probe." suffix)
+ZEN_TARGET_CLONE_PROBE_(void *, zen_target_clone_probe_resolver, "resolver");
+ZEN_TARGET_CLONE_PROBE_(int, zen_target_clone_probe_default, "default");
+#ifdef ZEN_TARGET_CLONE_ZNVER2
+ZEN_TARGET_CLONE_PROBE_(int, zen_target_clone_probe_znver2, "arch_znver2");
+#endif
+#ifdef ZEN_TARGET_CLONE_ZNVER3
+ZEN_TARGET_CLONE_PROBE_(int, zen_target_clone_probe_znver3, "arch_znver3");
+#endif
+#ifdef ZEN_TARGET_CLONE_ZNVER4
+ZEN_TARGET_CLONE_PROBE_(int, zen_target_clone_probe_znver4, "arch_znver4");
+#endif
+#ifdef ZEN_TARGET_CLONE_ZNVER5
+ZEN_TARGET_CLONE_PROBE_(int, zen_target_clone_probe_znver5, "arch_znver5");
+#endif
+
+/* "znver<N>", "default" (the baseline build), or "unknown" if the compiler named the clones differently */
+__attribute__((unused))
+static const char *zen_target_clone_selected(void) {
+    if (!zen_target_clone_probe_resolver) return "unknown";
+    __builtin_cpu_init(); /* As the loader does before running a resolver */
+    void *clone = zen_target_clone_probe_resolver();
+#ifdef ZEN_TARGET_CLONE_ZNVER5
+    if (clone == (void *)zen_target_clone_probe_znver5) return "znver5";
+#endif
+#ifdef ZEN_TARGET_CLONE_ZNVER4
+    if (clone == (void *)zen_target_clone_probe_znver4) return "znver4";
+#endif
+#ifdef ZEN_TARGET_CLONE_ZNVER3
+    if (clone == (void *)zen_target_clone_probe_znver3) return "znver3";
+#endif
+#ifdef ZEN_TARGET_CLONE_ZNVER2
+    if (clone == (void *)zen_target_clone_probe_znver2) return "znver2";
+#endif
+    if (clone == (void *)zen_target_clone_probe_default) return "default";
+    return "unknown";
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -2,7 +2,12 @@
 # See: https://github.com/NixOS/nixpkgs/blob/nixos-unstable/pkgs/stdenv/adapters.nix
 # See also (more tricky): https://github.com/NixOS/nixpkgs/blob/nixos-unstable/pkgs/build-support/cc-wrapper/default.nix
 { pkgs, lib ? pkgs.lib }:
-{
+let
+    # Where instrumented programs write their profile (*.gcda, one per object file, named after the
+    # object's path in the build directory). The training run redirects it into its $out with GCOV_PREFIX.
+    # The object paths must be the same in both builds, which holds in the sandbox (`sandbox-build-dir`).
+    pgoProfileDir = "/pgo-profile";
+in rec {
     wrapStdenv = {
         baseStdenv, # The env to wrap
         name,
@@ -27,4 +32,127 @@
         ]) // {
             inherit name;
         };
-}
\ No newline at end of file
+
+    # Profile-guided optimization (GCC): builds `package` instrumented, runs `training` on it and builds it again with
+    # the recorded profile. The profile is a derivation of its own, so it is cached like any other output.
+    # Returns { instrumented, profile, stdenv, optimized } - `optimized` being `package` built with `stdenv`.
+    # Note: python3 with `enableOptimizations` already runs its own PGO training (CPython's --enable-optimizations).
+    withPgo = {
+        baseStdenv, # The flags of this env apply to both builds
+        name ? "withPgo",
+        package, # stdenv -> derivation, e.g. (stdenv: pkgs.amd-libflame.override { inherit stdenv; })
+        training, # instrumented derivation -> shell commands exercising it, e.g. (p: "${p}/bin/blas-test-c 512 512 10")
+    }: rec {
+        instrumented = package (wrapStdenv {
+            inherit baseStdenv;
+            name = "${name}-generate";
+            # atomic: BLAS libraries update the counters from several threads
+            extraCFlagsCompile = [ "-fprofile-generate=${pgoProfileDir}" "-fprofile-update=atomic" ];
+        });
+
+        profile = pkgs.runCommand "${lib.getName instrumented}-pgo-profile" {} ''
+            export GCOV_PREFIX="$out"
+            ${training instrumented}
+            if [ -z "$(find "$out" -name '*.gcda' -print -quit 2>/dev/null)" ]; then
+                echo "withPgo: the training run of ${lib.getName instrumented} did not write any profile" >&2
+                exit 1
+            fi
+        '';
+
+        stdenv = wrapStdenv {
+            inherit baseStdenv name;
+            extraCFlagsCompile = [
+                "-fprofile-use=${profile}${pgoProfileDir}"
+                "-fprofile-partial-training" # Code the training didn't reach is still optimized for speed, not size
+                "-Wno-missing-profile" "-Wno-error=coverage-mismatch"
+                ];
+        };
+
+        optimized = package stdenv;
+    };
+
+    # Post-link layout optimization with llvm-bolt: builds `package` with relocations kept in its ELF files, records
+    # a perf profile of `training` and lets BOLT reorder functions and basic blocks of the `elfs` in a second build.
+    # Uses LBR (branch records) where the CPU and perf offer it, plain cycle sampling otherwise (e.g. Zen 3 and older).
+    # perf runs inside the build sandbox, so the host needs kernel.perf_event_paranoid <= 2.
+    # Returns { profiled, profile, optimized } - `optimized` is a drop-in for `package` (same outputs and file layout).
+    withBolt = {
+        baseStdenv,
+        name ? "withBolt",
+        package, # stdenv -> derivation, e.g. (stdenv: pkgs.python3.override { inherit stdenv; })
+        training, # profiled derivation -> shell commands exercising it
+        elfs, # ELF files in $out to optimize, e.g. [ "bin/python3.12" "lib/libpython3.12.so.1.0" ]; missing ones are skipped
+        perf ? pkgs.linuxPackages.perf,
+        bolt ? pkgs.llvmPackages.bolt,
+    }: rec {
+        # BOLT needs the relocations (to move functions) and the symbol table (to name them in the profile)
+        relocsStdenv = wrapStdenv {
+            inherit baseStdenv;
+            name = "${name}-relocs";
+            extraLdFlags = [ "--emit-relocs" ];
+        };
+        withRelocs = stdenv: (package stdenv).overrideAttrs { dontStrip = true; };
+        profiled = withRelocs relocsStdenv;
+
+        fdataName = elf: "${builtins.replaceStrings [ "/" ] [ "_" ] elf}.fdata";
+
+        profile = pkgs.runCommand "${lib.getName profiled}-bolt-profile" { nativeBuildInputs = [ perf bolt ]; } ''
+            mkdir -p $out
+            record() { perf record -o perf.data "$@" -- sh -c ${lib.escapeShellArg (training profiled)}; }
+            if record -e cycles:u -j any,u; then
+                mode=lbr
+            else
+                echo "withBolt: no branch records (LBR), falling back to sampling" >&2
+                record -e cycles:u
+                mode=sampling
+            fi
+            echo "$mode" >$out/mode
+            ${lib.concatMapStrings (elf: ''
+                if [ -e ${profiled}/${elf} ]; then
+                    perf2bolt $([ "$mode" = sampling ] && echo -nl) -p perf.data -o $out/${fdataName elf} ${profiled}/${elf}
+                fi
+            '') elfs}
+        '';
+
+        optimized = (withRelocs relocsStdenv).overrideAttrs (old: {
+            nativeBuildInputs = (old.nativeBuildInputs or []) ++ [ bolt ];
+            postFixup = (old.postFixup or "") + lib.concatMapStrings (elf: ''
+                if [ -e $out/${elf} ] && [ -e ${profile}/${fdataName elf} ]; then
+                    echo "withBolt: optimizing ${elf} ($(cat ${profile}/mode) profile)"
+                    llvm-bolt $out/${elf} -o $out/${elf}.bolt -data=${profile}/${fdataName elf} \
+                        -reorder-blocks=ext-tsp -reorder-functions=cdsort -split-functions -split-all-cold \
+                        -icf=1 -use-gnu-stack -infer-stale-profile -dyno-stats
+                    chmod --reference=$out/${elf} $out/${elf}.bolt
+                    mv $out/${elf}.bolt $out/${elf}
+                    $STRIP --strip-debug $out/${elf}
+                fi
+            '') elfs;
+        });
+    };
+
+    # Function multi-versioning (GCC target_clones): everything is built for the -march of `baseStdenv`, and the
+    # functions a program marks with ZEN_TARGET_CLONES are built once more for each of `amdZenVersions`. An ifunc
+    # resolver picks one when the program is loaded. An arch=znverN clone runs only on exactly that Zen generation
+    # (GCC compares the CPU model, not its features), every other CPU gets the baseline build ("default").
+    # The programs see
+    #   ZEN_TARGET_CLONES        the attribute, e.g. `ZEN_TARGET_CLONES static void kernel(...)`; not defined without clones
+    #   ZEN_TARGET_CLONE_ARCHS   the clones as a string, e.g. "znver5,znver4,znver3"
+    #   <zen-target-clones.h>    zen_target_clone_selected(): the clone in use (see include/zen-target-clones.h)
+    # Unmarked code is unaffected, so the env can be used for any package.
+    withTargetClones = {
+        baseStdenv,
+        name ? "withTargetClones",
+        amdZenVersions ? [ 3 4 5 ], # znver4 needs GCC >= 13, znver5 GCC >= 14
+    }: let
+        archs = map (v: "znver${toString v}") (lib.sort (a: b: a > b) amdZenVersions);
+        # No spaces: NIX_CFLAGS_COMPILE is split into words (the quotes stay part of the macro)
+        clones = lib.concatMapStrings (arch: ''"arch=${arch}",'') archs + ''"default"'';
+    in wrapStdenv {
+        inherit baseStdenv name;
+        extraCFlagsCompile = lib.optionals (archs != []) ([
+            "-DZEN_TARGET_CLONES=__attribute__((target_clones(${clones})))"
+            ''-DZEN_TARGET_CLONE_ARCHS="${lib.concatStringsSep "," archs}"''
+            "-isystem" "${./include}"
+        ] ++ map (arch: "-DZEN_TARGET_CLONE_${lib.toUpper arch}") archs);
+    };
+}
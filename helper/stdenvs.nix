@@ -63,4 +63,22 @@ in rec {
             ];
         # TODO: Do we want to also change `libc`?
     };
-}
\ No newline at end of file
+
+    # Profile-guided optimization on top of `safeTweaks`. Unlike the ones above, it is specific to one package
+    # and its training run: `(withPgo { package = stdenv: ...; training = pkg: "..."; }).optimized`
+    # See `withPgo` in my-stenv-adapter.nix
+    withPgo = args: stenvAdapter.withPgo ({ baseStdenv = safeTweaks; } // args);
+
+    # Post-link layout optimization (llvm-bolt) of selected ELF files of one package, driven by a perf profile of
+    # its training run: `(withBolt { package = stdenv: ...; training = pkg: "..."; elfs = [ ... ]; }).optimized`
+    # Pass `baseStdenv = withLto` to stack it onto LTO. See `withBolt` in my-stenv-adapter.nix
+    withBolt = args: stenvAdapter.withBolt ({ baseStdenv = safeTweaks; } // args);
+
+    # `safeTweaks` plus clones of marked hot functions for the Zen generations after `amdZenVersion`, picked at load
+    # time: one build still runs on the oldest machine but uses e.g. AVX-512 on Zen 4 and 5. Unmarked code is as in
+    # `safeTweaks`. See `withTargetClones` in my-stenv-adapter.nix
+    withTargetClones = stenvAdapter.withTargetClones {
+        baseStdenv = safeTweaks;
+        amdZenVersions = builtins.filter (v: v > amdZenVersion) [ 3 4 5 ];
+    };
+}
@@ -3,12 +3,14 @@
     basePythonPackage ? pkgs: pkgs.python3Minimal,
     isLtoEnabled ? false,
     isAggressiveFastMathEnabled ? false,
+    hwcapsVariants ? {}, # Further builds of libpython for lib/glibc-hwcaps/<level>/ (see zen-optimized-pkgs.nix)
 }:
-(final: prev: rec {
-    # https://search.nixos.org/packages?channel=unstable&show=python3&query=python3
-    python3 = (basePythonPackage prev).override {
+let
+    lib = unoptimizedPkgs.lib;
+    hwcaps = import ../../../helper/glibc-hwcaps.nix { inherit lib; };
+
+    interpreterArgs = {
         enableLTO = isLtoEnabled;
-        enableOptimizations = true; # Makes build non-reproducible!! # TODO: Enable "preferLocalBuild" setting
         reproducibleBuild = false; # only disables tests
 
         gdbm = null; withGdbm = false;
@@ -19,6 +21,22 @@
         bashNonInteractive = unoptimizedPkgs.bashNonInteractive;
 
         testers = [];
+    };
+in
+(final: prev: let
+    # The interpreter (i.e. libpython) for another Zen version. Building Python runs it, so this needs a builder
+    # of that generation (system feature gccarch-znverN); without the PGO training, which would run it even more.
+    libpythonFor = v: ((basePythonPackage prev).override (interpreterArgs // {
+        stdenv = if isAggressiveFastMathEnabled then v.stdenvs.withAggressiveFastMath else v.stdenvs.safeTweaks;
+        enableOptimizations = false;
+    })).overrideAttrs {
+        doCheck = false;
+        requiredSystemFeatures = [ "gccarch-znver${toString v.amdZenVersion}" ];
+    };
+in rec {
+    # https://search.nixos.org/packages?channel=unstable&show=python3&query=python3
+    python3 = hwcaps.withHwcaps (lib.mapAttrs (level: libpythonFor) hwcapsVariants) ((basePythonPackage prev).override (interpreterArgs // {
+        enableOptimizations = true; # Makes build non-reproducible!! # TODO: Enable "preferLocalBuild" setting
 
         packageOverrides = pyFinal: pyPrev:
             (import ./python-package-overrides.nix
@@ -28,5 +46,5 @@
                 { inherit optimizedPlatform unoptimizedPkgs isLtoEnabled isAggressiveFastMathEnabled; }
                 final prev pyFinal pyPrev) //
             { };
-      };
+      }));
 })
\ No newline at end of file
@@ -1,4 +1,3 @@
-
 # See: /docu/blas-implementations.adoc
 
 { optimizedPlatform, unoptimizedPkgs, stdenvs, amdZenVersion ? 2,
@@ -10,30 +9,54 @@
 
     stdenvLapackReference ? stdenvLapack, # No LTO here!
     stdenvBlas ? stdenvLapackReference,
+
+    # Further builds for lib/glibc-hwcaps/<level>/: { <level> = { amdZenVersion, stdenvs }; } (see zen-optimized-pkgs.nix)
+    hwcapsVariants ? {},
 }:
 let
+    lib = unoptimizedPkgs.lib;
     isUseOpenMP = true;
-in (final: prev: rec {
+    hwcaps = import ../../../helper/glibc-hwcaps.nix { inherit lib; };
+
+    # What a build targets: the stdenvs above are templates for `amdZenVersion`; `stdenvOf` maps them to the same
+    # template for another Zen version (`upstream` has no -march, so it stays).
+    base = { inherit amdZenVersion; isAvx512 = optimizedPlatform.isAvx512; stdenvOf = se: se; };
+    variants = lib.mapAttrs (level: v: {
+        inherit (v) amdZenVersion;
+        # Unlike optimizedPlatform.isAvx512 (Zen 5 only), also for Zen 4: the x86-64-v4 level these variants are
+        # installed for is only picked on CPUs with AVX-512, so its kernels are what the variant is for
+        isAvx512 = v.amdZenVersion >= 4;
+        stdenvOf = se: v.stdenvs.${se.name} or se;
+    }) hwcapsVariants;
+
+    # The package built for `base`, with its builds for the `variants` in lib/glibc-hwcaps/. The build host may not
+    # be able to run the variants' code, so their tests are skipped.
+    withVariants = build: hwcaps.withHwcaps
+        (lib.mapAttrs (level: t: (build t).overrideAttrs { doCheck = false; doInstallCheck = false; }) variants)
+        (build base);
+in (final: prev: let
     aocl-utils = prev.aocl-utils.override {
         # https://github.com/NixOS/nixpkgs/blob/nixos-25.05/pkgs/by-name/ao/aocl-utils/package.nix
         # TODO: We'd likely want fast-math here even if isAggressiveFastMathEnabled is disabled
     };
 
-    amd-blis = prev.amd-blis.override {
+    # The packages built for a target `t` (`base` or one of the `variants`)
+    amdBlisFor = t: prev.amd-blis.override {
         # https://github.com/NixOS/nixpkgs/blob/nixos-25.05/pkgs/by-name/am/amd-blis/package.nix#L70
-        stdenv = stdenvBlis;
+        stdenv = t.stdenvOf stdenvBlis;
 
         inherit (unoptimizedPkgs) perl; # TODO: Python
         blas64 = false; # TODO: check
         withOpenMP = isUseOpenMP; # TODO: check
-        withArchitecture = "zen${toString amdZenVersion}";
+        withArchitecture = "zen${toString t.amdZenVersion}";
     };
 
-    amd-libflame = prev.amd-libflame.override {
+    amdLibflameFor = t: prev.amd-libflame.override {
         # https://github.com/NixOS/nixpkgs/blob/nixos-25.05/pkgs/by-name/am/amd-libflame/package.nix
-        stdenv = stdenvLibflame;
+        stdenv = t.stdenvOf stdenvLibflame;
 
-        inherit amd-blis aocl-utils;
+        amd-blis = amdBlisFor t;
+        inherit aocl-utils;
         inherit (unoptimizedPkgs) cmake;
         inherit (final) gfortran;
         blas64 = false; # TODO: check
@@ -42,17 +65,23 @@ in (final: prev: rec {
     };
 
     # https://search.nixos.org/packages?channel=unstable&show=openblas&query=openblas
-    openblas = prev.openblas.override {
+    openblasFor = t: prev.openblas.override {
         # See https://github.com/NixOS/nixpkgs/blob/nixos-unstable/pkgs/development/libraries/science/math/openblas/default.nix
         # TODO: We'd likely want fast-math here even if isAggressiveFastMathEnabled is disabled
-        stdenv = stdenvOpenBlas;
+        stdenv = t.stdenvOf stdenvOpenBlas;
 
-        enableAVX512 = optimizedPlatform.isAvx512; # TODO: These kernels have been a source of trouble in the past.
+        enableAVX512 = t.isAvx512; # TODO: These kernels have been a source of trouble in the past.
         openmp = isUseOpenMP;
         # See https://github.com/OpenMathLib/OpenBLAS/blob/develop/TargetList.txt
         target = "ZEN";
         dynamicArch = false;  # prefer fixed-target
     };
+in rec {
+    inherit aocl-utils;
+
+    amd-blis = withVariants amdBlisFor;
+    amd-libflame = withVariants amdLibflameFor;
+    openblas = withVariants openblasFor;
 
     lapack-reference = prev.lapack-reference # AKA liblapack
         .override {
@@ -63,22 +92,25 @@ in (final: prev: rec {
             inherit (unoptimizedPkgs) cmake;
         };
 
-    blas = prev.blas.override {
+    # The `blas` and `lapack` wrappers copy the provider's libraries, so they carry glibc-hwcaps variants of their own
+    blas = withVariants (t: prev.blas.override {
         # https://search.nixos.org/packages?channel=unstable&show=blas&query=blas
         # https://github.com/NixOS/nixpkgs/blob/nixos-unstable/pkgs/by-name/bl/blas/package.nix
-        stdenv = stdenvBlas;
+        stdenv = t.stdenvOf stdenvBlas;
 
-        inherit openblas lapack-reference;
-        blasProvider = final.amd-blis;
-    };
+        openblas = openblasFor t;
+        inherit lapack-reference;
+        blasProvider = amdBlisFor t;
+    });
 
     # See also: la-pack https://github.com/ROCm/rocm-libraries
 
-    lapack = prev.lapack.override {
+    lapack = withVariants (t: prev.lapack.override {
         # https://search.nixos.org/packages?channel=unstable&show=lapack&query=lapack
         # https://github.com/NixOS/nixpkgs/blob/nixos-unstable/pkgs/by-name/la/lapack/package.nix
         # TODO: We'd likely want fast-math here even if isAggressiveFastMathEnabled is disabled
-        inherit openblas lapack-reference;
-        lapackProvider = final.amd-libflame;
-    };
-})
\ No newline at end of file
+        openblas = openblasFor t;
+        inherit lapack-reference;
+        lapackProvider = amdLibflameFor t;
+    });
+})
@@ -0,0 +1,85 @@
+# Before/after benchmark of the BOLT stage (`withBolt` in helper/stdenvs.nix) on the Python and R overlays
+# See documentation at ../docu/stdenvs.adoc
+#
+# Each interpreter is built twice with relocations kept: as is (before) and with its hot ELF files reordered by
+# llvm-bolt from a perf profile of the same workload (after). Both run the workload `runs` times, the best one counts.
+#   nix-build --max-jobs 1 --cores 0 ./test/bolt-comparison.nix && cat result/lib/comparison.json
+{
+    importablePkgsDelegate ? <nixpkgs>,
+    unoptimizedPkgs ? (import importablePkgsDelegate {}),
+    lib ? unoptimizedPkgs.lib,
+    pkgsTuned ? import ../zen-optimized-pkgs.nix { inherit importablePkgsDelegate unoptimizedPkgs lib; },
+    interpreterNames ? [ "python" "R" ],
+    runs ? 5,
+}:
+let
+    pkgs = unoptimizedPkgs;
+    stenvAdapter = pkgs.callPackage ../helper/my-stenv-adapter.nix {};
+
+    # Interpreter-bound: calls, dicts, strings and sorting, nothing that ends up in a C extension or BLAS
+    pythonWorkload = builtins.toFile "bolt-workload.py" ''
+        def fib(n):
+            return n if n < 2 else fib(n - 1) + fib(n - 2)
+        table = {str(i): i for i in range(300000)}
+        words = sorted(table, key=lambda s: s[::-1])
+        print(fib(25) + len(words))
+    '';
+    rWorkload = builtins.toFile "bolt-workload.R" ''
+        fib <- function(n) if (n < 2) n else fib(n - 1) + fib(n - 2)
+        keys <- sapply(1:50000, function(i) paste0("k", i))
+        cat(fib(22) + length(sort(keys)), "\n")
+    '';
+
+    interpreters = {
+        python = let python = pkgsTuned.python3; in {
+            package = stdenv: python.override { inherit stdenv; };
+            baseStdenv = pkgsTuned.stdenv;
+            run = p: "${p}/bin/python3 ${pythonWorkload}";
+            # Most of the interpreter lives in libpython with --enable-shared
+            elfs = [ "bin/${python.executable}" "lib/lib${python.libPrefix}.so.1.0" ];
+        };
+        R = {
+            package = stdenv: pkgsTuned.R.override { inherit stdenv; };
+            baseStdenv = pkgs.stdenv; # As in overlays/interpreter/r
+            run = p: "${p}/bin/Rscript ${rWorkload}";
+            elfs = [ "lib/R/lib/libR.so" "lib/R/bin/exec/R" ];
+        };
+    };
+
+    measure = name: let
+        i = interpreters.${name};
+        bolted = stenvAdapter.withBolt {
+            inherit (i) package baseStdenv elfs;
+            name = "withBolt-${name}";
+            training = i.run;
+        };
+        timed = p: lib.escapeShellArg (i.run p);
+        run = pkgs.runCommand "bolt-comparison-${name}" {} ''
+            # Best wall time in seconds of `runs` alternating runs of both builds
+            before= after=
+            for _ in $(seq ${toString runs}); do
+                for build in before after; do
+                    cmd=${timed bolted.profiled}
+                    [ $build = after ] && cmd=${timed bolted.optimized}
+                    t0=$(date +%s.%N); sh -c "$cmd" >/dev/null; t1=$(date +%s.%N)
+                    eval "best=\$$build"
+                    best=$(awk -v t0=$t0 -v t1=$t1 -v best="$best" 'BEGIN { d = t1 - t0; print (best == "" || d < best) ? d : best }')
+                    eval "$build=\$best"
+                done
+            done
+            mkdir -p $out/lib
+            awk -v b=$before -v a=$after -v mode=$(cat ${bolted.profile}/mode) 'BEGIN {
+                printf "{\"interpreter\": \"${name}\", \"profile\": \"%s\", \"before_sec\": %.6f, \"after_sec\": %.6f, \"speedup\": %.4f}\n", mode, b, a, b / a
+            }' >$out/lib/result.json
+        '';
+    in builtins.fromJSON (builtins.readFile "${run}/lib/result.json"); # Json was created by executing program
+
+    results = map measure interpreterNames;
+in pkgs.runCommand "bolt-comparison" {
+    comparisonJson = builtins.toJSON results;
+    passAsFile = [ "comparisonJson" ];
+    passthru = { inherit results; };
+} ''
+    mkdir -p $out/lib
+    cp "$comparisonJsonPath" $out/lib/comparison.json
+''
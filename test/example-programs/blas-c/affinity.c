@@ -0,0 +1,130 @@
+#define _GNU_SOURCE 1
+
+#include "affinity.h"
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* policy_names[AFFINITY_MAX_POLICIES] = { "none", "close", "spread", "ccx" };
+
+int affinity_parse_policies(const char* s, AffinityPolicy* out, int max) {
+  int n = 0;
+  while (*s) {
+    const size_t len = strcspn(s, ",");
+    int found = -1;
+    for (int p = 0; p < AFFINITY_MAX_POLICIES; ++p) {
+      if (strlen(policy_names[p]) == len && strncmp(s, policy_names[p], len) == 0) found = p;
+    }
+    if (found < 0 || n >= max) return 0;
+    out[n++] = (AffinityPolicy)found;
+    s += len;
+    if (*s == ',') ++s;
+  }
+  return n;
+}
+
+const char* affinity_policy_name(AffinityPolicy p) {
+  return p >= 0 && p < AFFINITY_MAX_POLICIES ? policy_names[p] : "none";
+}
+
+static int parse_cpu_list(const char* s, cpu_set_t* set) {
+  CPU_ZERO(set);
+  int count = 0;
+  while (*s) {
+    char* end;
+    long a = strtol(s, &end, 10);
+    if (end == s) break;
+    long b = a;
+    if (*end == '-') b = strtol(end + 1, &end, 10);
+    for (long c = a; c <= b && c < CPU_SETSIZE; ++c) { CPU_SET((int)c, set); ++count; }
+    s = end;
+    while (*s == ',' || *s == '\n' || *s == ' ') ++s;
+  }
+  return count;
+}
+
+void affinity_l3_domain_of(int cpu, cpu_set_t* set) {
+  char path[128], line[1024];
+  snprintf(path, sizeof path, "/sys/devices/system/cpu/cpu%d/cache/index3/shared_cpu_list", cpu);
+  FILE* f = fopen(path, "r");
+  if (f) {
+    const int ok = fgets(line, sizeof line, f) != NULL;
+    fclose(f);
+    if (ok && parse_cpu_list(line, set) > 0) return;
+  }
+  CPU_ZERO(set);
+  CPU_SET(cpu, set);
+}
+
+int affinity_cpus_by_l3_domain(int* order, int* start, int* len, int* ndom) {
+  cpu_set_t allowed, done;
+  *ndom = 0;
+  if (sched_getaffinity(0, sizeof allowed, &allowed) != 0) return 0;
+  CPU_ZERO(&done);
+  int n = 0;
+  for (int c = 0; c < CPU_SETSIZE; ++c) {
+    if (!CPU_ISSET(c, &allowed) || CPU_ISSET(c, &done)) continue;
+    cpu_set_t dom;
+    affinity_l3_domain_of(c, &dom);
+    start[*ndom] = n;
+    for (int d = 0; d < CPU_SETSIZE; ++d) {
+      if (CPU_ISSET(d, &dom) && CPU_ISSET(d, &allowed) && !CPU_ISSET(d, &done)) {
+        CPU_SET(d, &done);
+        order[n++] = d;
+      }
+    }
+    len[*ndom] = n - start[*ndom];
+    ++*ndom;
+  }
+  return n;
+}
+
+// Appends "{a,b,...}" (and a separating comma) to buf
+static size_t append_place(char* buf, size_t pos, const int* cpus, int n) {
+  pos += sprintf(buf + pos, "%s{", pos > 0 ? "," : "");
+  for (int i = 0; i < n; ++i) pos += sprintf(buf + pos, "%s%d", i > 0 ? "," : "", cpus[i]);
+  pos += sprintf(buf + pos, "}");
+  return pos;
+}
+
+// OMP_PLACES for `p`: close lists the cores domain by domain (thread t -> place t with
+// OMP_PROC_BIND=close), spread the same list with OMP_PROC_BIND=spread, and ccx one place per
+// CPU whose set is that CPU's whole L3 domain, so thread t may use any CPU of its domain.
+static char* omp_places(AffinityPolicy p) {
+  static int order[CPU_SETSIZE], start[CPU_SETSIZE], len[CPU_SETSIZE];
+  int ndom = 0;
+  const int n = affinity_cpus_by_l3_domain(order, start, len, &ndom);
+  if (n == 0) return NULL;
+  // "{cpu}," is at most 8 characters; ccx repeats each domain once per CPU in it
+  size_t cap = 8 * (size_t)n + 1;
+  if (p == AFFINITY_CCX) for (int d = 0; d < ndom; ++d) cap += 8 * (size_t)len[d] * len[d];
+  char* buf = (char*)malloc(cap);
+  if (!buf) return NULL;
+  size_t pos = 0;
+  buf[0] = '\0';
+  for (int d = 0; d < ndom; ++d) {
+    for (int i = 0; i < len[d]; ++i) {
+      pos = p == AFFINITY_CCX ? append_place(buf, pos, order + start[d], len[d])
+                              : append_place(buf, pos, order + start[d] + i, 1);
+    }
+  }
+  return buf;
+}
+
+int affinity_apply_env(AffinityPolicy p) {
+  if (setenv("BLAS_TEST_BIND", affinity_policy_name(p), 1) != 0) return 1;
+  if (p == AFFINITY_NONE) return 0;
+  char* places = omp_places(p);
+  if (!places) return 1;
+  const int rc = setenv("OMP_PLACES", places, 1) != 0 ||
+                 setenv("OMP_PROC_BIND", p == AFFINITY_SPREAD ? "spread" : "close", 1) != 0 ||
+                 setenv("BLAS_PLAIN_PIN", p == AFFINITY_CLOSE ? "core" : p == AFFINITY_SPREAD ? "spread" : "ccx", 1) != 0;
+  free(places);
+  return rc;
+}
+
+int affinity_env_applied(AffinityPolicy p) {
+  const char* s = getenv("BLAS_TEST_BIND");
+  return s && strcmp(s, affinity_policy_name(p)) == 0;
+}
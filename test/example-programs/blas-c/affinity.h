@@ -0,0 +1,46 @@
+#pragma once
+#include <sched.h> // cpu_set_t: include this header after defining _GNU_SOURCE
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Thread binding policies for the BLAS libraries' worker threads (--bind).
+//
+// The OpenMP runtimes behind BLIS/OpenBLAS read OMP_PROC_BIND/OMP_PLACES once, when they are
+// loaded, so a policy is applied through the environment before the process (re-)executes;
+// PlainC reads BLAS_PLAIN_PIN in blas_init(). Places are listed explicitly, ordered by L3
+// domain (CCX on Zen, from sysfs), so thread t of a sweep lands on the same CPUs in every library.
+
+typedef enum AffinityPolicy {
+  AFFINITY_NONE = 0, // leave the environment alone (library defaults)
+  AFFINITY_CLOSE,    // one core per thread, filling an L3 domain before the next
+  AFFINITY_SPREAD,   // one core per thread, round-robin over the L3 domains
+  AFFINITY_CCX       // one L3 domain per thread (free to move inside it), filling a domain before the next
+} AffinityPolicy;
+
+#define AFFINITY_MAX_POLICIES 4
+
+// Parses "close,spread,ccx" etc. into `out`; returns the number of policies, 0 on error.
+int affinity_parse_policies(const char* s, AffinityPolicy* out, int max);
+
+const char* affinity_policy_name(AffinityPolicy p);
+
+// Sets OMP_PROC_BIND, OMP_PLACES and BLAS_PLAIN_PIN for `p` (AFFINITY_NONE leaves them alone)
+// and records `p` in BLAS_TEST_BIND. Returns 0 on success.
+int affinity_apply_env(AffinityPolicy p);
+
+// Whether the environment of this process was set up for `p` by affinity_apply_env()
+int affinity_env_applied(AffinityPolicy p);
+
+// CPUs sharing cpu's L3 (its CCX on Zen, from sysfs); the CPU itself if sysfs doesn't say.
+// Also used by PlainC's own worker pinning (BLAS_PLAIN_PIN).
+void affinity_l3_domain_of(int cpu, cpu_set_t* set);
+
+// Allowed CPUs grouped by L3 domain: order[start[d] .. start[d] + len[d]) is domain d.
+// The arrays need CPU_SETSIZE entries. Returns the number of CPUs; *ndom receives the number of domains.
+int affinity_cpus_by_l3_domain(int* order, int* start, int* len, int* ndom);
+
+#ifdef __cplusplus
+}
+#endif
@@ -8,22 +8,150 @@ extern "C" {
 // Opaque handle so main doesn't know about CPU/GPU details
 typedef struct BlasHandle BlasHandle;
 
+typedef enum BlasPrecision {
+  BLAS_PREC_S = 0, // float
+  BLAS_PREC_D,     // double
+  BLAS_PREC_C,     // float complex (interleaved re, im)
+  BLAS_PREC_Z      // double complex (interleaved re, im)
+} BlasPrecision;
+
+typedef enum BlasTranspose {
+  BLAS_OP_N = 0,   // op(X) = X
+  BLAS_OP_T,       // op(X) = X^T
+  BLAS_OP_C        // op(X) = X^H (same as BLAS_OP_T for real precisions)
+} BlasTranspose;
+
+// One GEMM call: C = alpha * op(A) * op(B) + beta * C, all matrices row-major.
+// op(A): MxK, op(B): KxN, C: MxN
+// A is stored as MxK (BLAS_OP_N) or KxM (otherwise) with row stride lda; same for B (KxN / NxK, ldb).
+// alpha/beta are given as {re, im}; the imaginary part is ignored for real precisions.
+typedef struct BlasGemmArgs {
+  BlasPrecision prec;
+  BlasTranspose transA, transB;
+  int M, N, K;
+  int lda, ldb, ldc;
+  double alpha[2];
+  double beta[2];
+} BlasGemmArgs;
+
+// Bytes per matrix element for a precision (4, 8, 8, 16).
+static inline size_t blas_precision_size(BlasPrecision p) {
+  switch (p) {
+    case BLAS_PREC_D: return 8;
+    case BLAS_PREC_C: return 8;
+    case BLAS_PREC_Z: return 16;
+    default:          return 4;
+  }
+}
+
 // Prepare backend (may allocate GPU buffers, create handles, etc.)
+// M/N/K are a sizing hint; blas_gemm() may be called with other shapes.
 BlasHandle* blas_init(int M, int N, int K);
 
+// Run GEMM `warmup` times untimed, then `repeats` times timed, as described by `args`.
+// If `samples` is non-NULL it must hold `repeats` entries and receives the seconds of each timed call.
+// Returns total seconds spent inside the repeated GEMMs (excluding init/finalize/warmup), negative on failure.
+double blas_gemm(BlasHandle* h, const BlasGemmArgs* args,
+                 const void* A, const void* B, void* C,
+                 int warmup, int repeats, double* samples);
+
 // Run SGEMM repeatedly: C = A*B (alpha=1, beta=0), row-major, no-transpose
 // A: MxK, B: KxN, C: MxN
 // Returns total seconds spent inside the repeated GEMMs (excluding init/finalize).
-double blas_sgemm(BlasHandle* h,
-                  const float* A, const float* B, float* C,
-                  int M, int N, int K,
-                  int repeats);
+static inline double blas_sgemm(BlasHandle* h,
+                                const float* A, const float* B, float* C,
+                                int M, int N, int K,
+                                int repeats) {
+  BlasGemmArgs args = { BLAS_PREC_S, BLAS_OP_N, BLAS_OP_N, M, N, K, K, N, N, { 1.0, 0.0 }, { 0.0, 0.0 } };
+  return blas_gemm(h, &args, A, B, C, 1, repeats, NULL);
+}
+
+// Strided batch: `batch` independent GEMMs described by the same `args`; matrix i reads
+// A + i*strideA and B + i*strideB and writes C + i*strideC (strides in elements, e.g. rows*ld).
+// One warmup/timed call runs the whole batch; samples/return value as for blas_gemm().
+double blas_gemm_strided_batched(BlasHandle* h, const BlasGemmArgs* args,
+                                 const void* A, long strideA,
+                                 const void* B, long strideB,
+                                 void* C, long strideC,
+                                 int batch, int warmup, int repeats, double* samples);
+
+// Run a batch of `batch` tightly packed SGEMMs repeatedly: C_i = A_i*B_i (alpha=1, beta=0), row-major
+// A_i: MxK, B_i: KxN, C_i: MxN, stored back to back
+// Returns total seconds spent inside the repeated batches.
+static inline double blas_sgemm_batched(BlasHandle* h,
+                                        const float* A, const float* B, float* C,
+                                        int M, int N, int K,
+                                        int batch, int repeats) {
+  BlasGemmArgs args = { BLAS_PREC_S, BLAS_OP_N, BLAS_OP_N, M, N, K, K, N, N, { 1.0, 0.0 }, { 0.0, 0.0 } };
+  return blas_gemm_strided_batched(h, &args, A, (long)M * K, B, (long)K * N, C, (long)M * N,
+                                   batch, 1, repeats, NULL);
+}
+
+// Memory-bound level-1/level-2 kernels (real precisions only), see blas_vector()
+typedef enum BlasVectorOp {
+  BLAS_VEC_AXPY = 0, // y = alpha*x + y                    x, y: N
+  BLAS_VEC_DOT,      // result = x.y                        x, y: N
+  BLAS_VEC_NRM2,     // result = ||x||_2                    x: N
+  BLAS_VEC_GEMV,     // y = alpha*A*x + beta*y              A: MxN, x: N, y: M
+  BLAS_VEC_GER,      // A = alpha*x*y^T + A                 A: MxN, x: M, y: N
+  BLAS_VEC_TRSV      // x = L^-1 * x, L = lower triangle of A (non-unit diagonal), A: NxN, x: N
+} BlasVectorOp;
+
+typedef struct BlasVectorArgs {
+  BlasVectorOp op;
+  BlasPrecision prec; // BLAS_PREC_S or BLAS_PREC_D
+  int M, N;           // M is ignored by level-1 ops and TRSV
+  double alpha, beta;
+} BlasVectorArgs;
+
+// Run one level-1/level-2 kernel `warmup` times untimed, then `repeats` times timed.
+// A is row-major with row stride N, x and y are contiguous (unit increments).
+// `result` (may be NULL) receives the scalar of DOT/NRM2 from the last call.
+// samples/return value as for blas_gemm(); negative if the op is unsupported or failed.
+double blas_vector(BlasHandle* h, const BlasVectorArgs* args, void* A, void* x, void* y,
+                   int warmup, int repeats, double* samples, double* result);
+
+// Set the number of threads used by subsequent GEMM calls (n <= 0 only queries).
+// Returns the number of threads now in effect, or -1 if the backend can't control it.
+int blas_set_num_threads(BlasHandle* h, int n);
 
 // Cleanup backend (destroy handles, free device memory, etc.)
 void blas_finalize(BlasHandle* h);
 
 size_t blas_get_engine_info(char* buf, size_t len);
 
+// Plugin ABI: every backend also exports its functions as a vtable named BLAS_BACKEND_SYMBOL,
+// so a backend built as a shared object can be loaded at runtime (see main.c, --plugin=).
+#define BLAS_BACKEND_ABI_VERSION 3
+#define BLAS_BACKEND_SYMBOL "blas_backend"
+
+typedef struct BlasBackend {
+  int abi_version;     // BLAS_BACKEND_ABI_VERSION the backend was built against
+  const char* id;      // short name, e.g. "cblas", "plain", "rocblas"
+  BlasHandle* (*init)(int M, int N, int K);
+  double (*gemm)(BlasHandle* h, const BlasGemmArgs* args,
+                 const void* A, const void* B, void* C,
+                 int warmup, int repeats, double* samples);
+  int (*set_num_threads)(BlasHandle* h, int n);
+  void (*finalize)(BlasHandle* h);
+  size_t (*get_engine_info)(char* buf, size_t len);
+  // since ABI 2
+  double (*gemm_strided_batched)(BlasHandle* h, const BlasGemmArgs* args,
+                                 const void* A, long strideA, const void* B, long strideB,
+                                 void* C, long strideC,
+                                 int batch, int warmup, int repeats, double* samples);
+  // since ABI 3
+  double (*vector)(BlasHandle* h, const BlasVectorArgs* args, void* A, void* x, void* y,
+                   int warmup, int repeats, double* samples, double* result);
+} BlasBackend;
+
+extern const BlasBackend blas_backend;
+
+#define BLAS_DEFINE_BACKEND(ID) \
+  const BlasBackend blas_backend = { BLAS_BACKEND_ABI_VERSION, ID, blas_init, blas_gemm, \
+                                     blas_set_num_threads, blas_finalize, blas_get_engine_info, \
+                                     blas_gemm_strided_batched, blas_vector }
+
 #ifdef __cplusplus
 }
 #endif
@@ -6,6 +6,8 @@
 #include <time.h>
 #include <dlfcn.h>
 #include <stdio.h>
+#include <limits.h>
+#include <sched.h>
 
 #ifdef __has_include
 #  if __has_include(<cblas.h>)
@@ -50,7 +52,39 @@ static void json_escape_str(const char* in, char* out, size_t out_len) {
   out[j] = '\0';
 }
 
-struct BlasHandle { int dummy; };
+// Strided-batch GEMM of the CBLAS provider, if it has one (oneMKL: cblas_?gemm_batch_strided).
+// Layout/transposes are passed as their CBLAS enum values, sizes and strides as LP64 MKL_INT.
+typedef void (*sgemm_batch_strided_fn)(int, int, int, int, int, int, float, const float*, int, int,
+                                       const float*, int, int, float, float*, int, int, int);
+typedef void (*dgemm_batch_strided_fn)(int, int, int, int, int, int, double, const double*, int, int,
+                                       const double*, int, int, double, double*, int, int, int);
+typedef void (*cgemm_batch_strided_fn)(int, int, int, int, int, int, const void*, const void*, int, int,
+                                       const void*, int, int, const void*, void*, int, int, int);
+
+// Runtime thread control of the CBLAS provider, tried in this order (the first setter found wins):
+// BLIS (dim_t, 64 bits in the default build), OpenBLAS, oneMKL, and plain OpenMP for libraries that
+// only use the OpenMP team size (e.g. an OpenMP build without its own setter).
+typedef void (*set_threads_long_fn)(long);
+typedef void (*set_threads_int_fn)(int);
+
+typedef struct ThreadApi {
+  const char* name;       // the setter, e.g. "openblas_set_num_threads"
+  int is_long;            // dim_t argument (BLIS)
+} ThreadApi;
+
+static const ThreadApi thread_apis[] = {
+  { "bli_thread_set_num_threads", 1 },
+  { "openblas_set_num_threads",   0 },
+  { "mkl_set_num_threads",        0 },
+  { "omp_set_num_threads",        0 },
+};
+
+struct BlasHandle {
+  void* batch_strided[4]; // per BlasPrecision, NULL: loop over cblas_?gemm
+  const ThreadApi* api;   // NULL: the library's threads can't be controlled
+  void* set_threads;
+  int nthreads;           // last count set; before that the CPUs in the affinity mask (a sweep's upper end)
+};
 
 static double now_sec(void) {
   struct timespec ts;
@@ -58,49 +92,232 @@ static double now_sec(void) {
   return ts.tv_sec + ts.tv_nsec * 1e-9;
 }
 
+// The shared object providing cblas_sgemm (falls back to the global scope); dlclose() if not RTLD_DEFAULT
+static void* cblas_provider(const char** so_path) {
+  Dl_info info;
+  void* provider = RTLD_DEFAULT;
+  if (so_path) *so_path = NULL;
+  if (dladdr((void*)cblas_sgemm, &info) && info.dli_fname) {
+    void* h = dlopen(info.dli_fname, RTLD_NOLOAD | RTLD_LAZY);
+    if (h) provider = h;
+    if (so_path) *so_path = info.dli_fname;
+  }
+  return provider;
+}
+
+// Like the engine probe: the provider first (and its dependencies, e.g. libgomp), then the global scope
+static void* provider_sym(void* provider, const char* name) {
+  void* fn = dlsym(provider, name);
+  return fn ? fn : dlsym(RTLD_DEFAULT, name);
+}
+
+// The first entry of thread_apis the provider exports, with its setter in *set
+static const ThreadApi* resolve_thread_api(void* provider, void** set) {
+  for (size_t i = 0; i < sizeof thread_apis / sizeof thread_apis[0]; ++i) {
+    if ((*set = provider_sym(provider, thread_apis[i].name))) return &thread_apis[i];
+  }
+  return NULL;
+}
+
+static int allowed_cpus(void) {
+  cpu_set_t allowed;
+  return sched_getaffinity(0, sizeof allowed, &allowed) == 0 && CPU_COUNT(&allowed) > 0 ? CPU_COUNT(&allowed) : 1;
+}
+
 BlasHandle* blas_init(int M, int N, int K) {
   (void)M; (void)N; (void)K;
   BlasHandle* h = (BlasHandle*)calloc(1, sizeof(BlasHandle));
+  if (!h) return NULL;
+  static const char* names[4] = {
+    "cblas_sgemm_batch_strided", "cblas_dgemm_batch_strided",
+    "cblas_cgemm_batch_strided", "cblas_zgemm_batch_strided"
+  };
+  void* provider = cblas_provider(NULL);
+  for (int p = 0; p < 4; ++p) h->batch_strided[p] = dlsym(provider, names[p]);
+  h->api = resolve_thread_api(provider, &h->set_threads);
+  h->nthreads = allowed_cpus();
+  if (provider != RTLD_DEFAULT && provider) dlclose(provider);
   return h;
 }
 
-double blas_sgemm(BlasHandle* h,
-                  const float* A, const float* B, float* C,
-                  int M, int N, int K,
-                  int repeats) {
+static enum CBLAS_TRANSPOSE to_cblas_trans(BlasTranspose t) {
+  switch (t) {
+    case BLAS_OP_T: return CblasTrans;
+    case BLAS_OP_C: return CblasConjTrans;
+    default:        return CblasNoTrans;
+  }
+}
+
+// One cblas_?gemm call for the precision in `g`
+static void gemm_once(const BlasGemmArgs* g, const void* A, const void* B, void* C) {
+  const enum CBLAS_TRANSPOSE ta = to_cblas_trans(g->transA), tb = to_cblas_trans(g->transB);
+  switch (g->prec) {
+    case BLAS_PREC_S:
+      cblas_sgemm(CblasRowMajor, ta, tb, g->M, g->N, g->K,
+                  (float)g->alpha[0], (const float*)A, g->lda, (const float*)B, g->ldb,
+                  (float)g->beta[0], (float*)C, g->ldc);
+      break;
+    case BLAS_PREC_D:
+      cblas_dgemm(CblasRowMajor, ta, tb, g->M, g->N, g->K,
+                  g->alpha[0], (const double*)A, g->lda, (const double*)B, g->ldb,
+                  g->beta[0], (double*)C, g->ldc);
+      break;
+    case BLAS_PREC_C: {
+      const float alpha[2] = { (float)g->alpha[0], (float)g->alpha[1] };
+      const float beta[2]  = { (float)g->beta[0],  (float)g->beta[1] };
+      cblas_cgemm(CblasRowMajor, ta, tb, g->M, g->N, g->K,
+                  alpha, A, g->lda, B, g->ldb, beta, C, g->ldc);
+      break;
+    }
+    case BLAS_PREC_Z:
+      cblas_zgemm(CblasRowMajor, ta, tb, g->M, g->N, g->K,
+                  g->alpha, A, g->lda, B, g->ldb, g->beta, C, g->ldc);
+      break;
+  }
+}
+
+// One strided batch: the provider's batch call if there is one, else one cblas_?gemm per matrix
+static void gemm_batch_once(const BlasHandle* h, const BlasGemmArgs* g,
+                            const void* A, long sA, const void* B, long sB, void* C, long sC, int batch) {
+  const int layout = CblasRowMajor, ta = to_cblas_trans(g->transA), tb = to_cblas_trans(g->transB);
+  // MKL_INT is 32 bits in the LP64 interface
+  void* fn = sA <= INT_MAX && sB <= INT_MAX && sC <= INT_MAX ? h->batch_strided[g->prec] : NULL;
+  if (fn) {
+    switch (g->prec) {
+      case BLAS_PREC_S:
+        ((sgemm_batch_strided_fn)fn)(layout, ta, tb, g->M, g->N, g->K,
+                                     (float)g->alpha[0], (const float*)A, g->lda, (int)sA,
+                                     (const float*)B, g->ldb, (int)sB,
+                                     (float)g->beta[0], (float*)C, g->ldc, (int)sC, batch);
+        break;
+      case BLAS_PREC_D:
+        ((dgemm_batch_strided_fn)fn)(layout, ta, tb, g->M, g->N, g->K,
+                                     g->alpha[0], (const double*)A, g->lda, (int)sA,
+                                     (const double*)B, g->ldb, (int)sB,
+                                     g->beta[0], (double*)C, g->ldc, (int)sC, batch);
+        break;
+      case BLAS_PREC_C: {
+        const float alpha[2] = { (float)g->alpha[0], (float)g->alpha[1] };
+        const float beta[2]  = { (float)g->beta[0],  (float)g->beta[1] };
+        ((cgemm_batch_strided_fn)fn)(layout, ta, tb, g->M, g->N, g->K,
+                                     alpha, A, g->lda, (int)sA, B, g->ldb, (int)sB, beta, C, g->ldc, (int)sC, batch);
+        break;
+      }
+      case BLAS_PREC_Z:
+        ((cgemm_batch_strided_fn)fn)(layout, ta, tb, g->M, g->N, g->K,
+                                     g->alpha, A, g->lda, (int)sA, B, g->ldb, (int)sB, g->beta, C, g->ldc, (int)sC, batch);
+        break;
+    }
+    return;
+  }
+  const size_t esz = blas_precision_size(g->prec);
+  for (int i = 0; i < batch; ++i) {
+    gemm_once(g, (const char*)A + (size_t)i * sA * esz, (const char*)B + (size_t)i * sB * esz,
+              (char*)C + (size_t)i * sC * esz);
+  }
+}
+
+double blas_gemm(BlasHandle* h, const BlasGemmArgs* args,
+                 const void* A, const void* B, void* C,
+                 int warmup, int repeats, double* samples) {
   (void)h;
-  const float alpha = 1.0f, beta = 0.0f;
 
-  // Warmup
-  cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans,
-              M, N, K, alpha, A, K, B, N, beta, C, N);
+  for (int w = 0; w < warmup; ++w) {
+    gemm_once(args, A, B, C);
+  }
 
-  double t0 = now_sec();
+  double t0 = now_sec(), t = t0;
   for (int r = 0; r < repeats; ++r) {
-    cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans,
-                M, N, K, alpha, A, K, B, N, beta, C, N);
+    gemm_once(args, A, B, C);
+    if (samples) { const double t1 = now_sec(); samples[r] = t1 - t; t = t1; }
   }
   double t1 = now_sec();
   return t1 - t0;
 }
 
+double blas_gemm_strided_batched(BlasHandle* h, const BlasGemmArgs* args,
+                                 const void* A, long strideA, const void* B, long strideB,
+                                 void* C, long strideC,
+                                 int batch, int warmup, int repeats, double* samples) {
+  for (int w = 0; w < warmup; ++w) {
+    gemm_batch_once(h, args, A, strideA, B, strideB, C, strideC, batch);
+  }
+
+  double t0 = now_sec(), t = t0;
+  for (int r = 0; r < repeats; ++r) {
+    gemm_batch_once(h, args, A, strideA, B, strideB, C, strideC, batch);
+    if (samples) { const double t1 = now_sec(); samples[r] = t1 - t; t = t1; }
+  }
+  double t1 = now_sec();
+  return t1 - t0;
+}
+
+// One level-1/level-2 call; DOT/NRM2 store their scalar in *result
+static int vector_once(const BlasVectorArgs* v, void* A, void* x, void* y, double* result) {
+  const int M = v->M, N = v->N;
+  if (v->prec == BLAS_PREC_S) {
+    float* a = (float*)A; float* xs = (float*)x; float* ys = (float*)y;
+    const float alpha = (float)v->alpha, beta = (float)v->beta;
+    switch (v->op) {
+      case BLAS_VEC_AXPY: cblas_saxpy(N, alpha, xs, 1, ys, 1); return 0;
+      case BLAS_VEC_DOT:  *result = cblas_sdot(N, xs, 1, ys, 1); return 0;
+      case BLAS_VEC_NRM2: *result = cblas_snrm2(N, xs, 1); return 0;
+      case BLAS_VEC_GEMV: cblas_sgemv(CblasRowMajor, CblasNoTrans, M, N, alpha, a, N, xs, 1, beta, ys, 1); return 0;
+      case BLAS_VEC_GER:  cblas_sger(CblasRowMajor, M, N, alpha, xs, 1, ys, 1, a, N); return 0;
+      case BLAS_VEC_TRSV: cblas_strsv(CblasRowMajor, CblasLower, CblasNoTrans, CblasNonUnit, N, a, N, xs, 1); return 0;
+    }
+  } else if (v->prec == BLAS_PREC_D) {
+    double* a = (double*)A; double* xd = (double*)x; double* yd = (double*)y;
+    switch (v->op) {
+      case BLAS_VEC_AXPY: cblas_daxpy(N, v->alpha, xd, 1, yd, 1); return 0;
+      case BLAS_VEC_DOT:  *result = cblas_ddot(N, xd, 1, yd, 1); return 0;
+      case BLAS_VEC_NRM2: *result = cblas_dnrm2(N, xd, 1); return 0;
+      case BLAS_VEC_GEMV: cblas_dgemv(CblasRowMajor, CblasNoTrans, M, N, v->alpha, a, N, xd, 1, v->beta, yd, 1); return 0;
+      case BLAS_VEC_GER:  cblas_dger(CblasRowMajor, M, N, v->alpha, xd, 1, yd, 1, a, N); return 0;
+      case BLAS_VEC_TRSV: cblas_dtrsv(CblasRowMajor, CblasLower, CblasNoTrans, CblasNonUnit, N, a, N, xd, 1); return 0;
+    }
+  }
+  return -1;
+}
+
+double blas_vector(BlasHandle* h, const BlasVectorArgs* args, void* A, void* x, void* y,
+                   int warmup, int repeats, double* samples, double* result) {
+  (void)h;
+  double scalar = 0.0;
+  for (int w = 0; w < warmup; ++w) {
+    if (vector_once(args, A, x, y, &scalar) != 0) return -1.0;
+  }
+
+  double t0 = now_sec(), t = t0;
+  for (int r = 0; r < repeats; ++r) {
+    if (vector_once(args, A, x, y, &scalar) != 0) return -1.0;
+    if (samples) { const double t1 = now_sec(); samples[r] = t1 - t; t = t1; }
+  }
+  double t1 = now_sec();
+  if (result) *result = scalar;
+  return t1 - t0;
+}
+
+int blas_set_num_threads(BlasHandle* h, int n) {
+  if (!h || !h->api) return -1; // threading is owned by the BLAS library
+  if (n <= 0) return h->nthreads;
+  if (h->api->is_long) ((set_threads_long_fn)h->set_threads)((long)n);
+  else ((set_threads_int_fn)h->set_threads)(n);
+  h->nthreads = n;
+  return n;
+}
+
 void blas_finalize(BlasHandle* h) {
   free(h);
 }
 
-size_t blas_get_engine_info(char* buf, size_t len) {
+static size_t library_info(char* buf, size_t len) {
   if (!buf || len == 0) return 0;
   buf[0] = '\0';
 
   // Identify the shared object that provides cblas_sgemm
-  Dl_info info;
-  void* provider = RTLD_DEFAULT;
   const char* so_path = NULL;
-  if (dladdr((void*)cblas_sgemm, &info) && info.dli_fname) {
-    void* h = dlopen(info.dli_fname, RTLD_NOLOAD | RTLD_LAZY);
-    if (h) provider = h;
-    so_path = info.dli_fname;
-  }
+  void* provider = cblas_provider(&so_path);
   char so_esc[512];
   json_escape_str(so_path ? so_path : "unknown", so_esc, sizeof so_esc);
 
@@ -157,3 +374,18 @@ size_t blas_get_engine_info(char* buf, size_t len) {
   if (provider != RTLD_DEFAULT && provider) dlclose(provider);
   return strlen(buf);
 }
+
+// Engine JSON of the provider plus the thread API found for it (see thread_apis)
+size_t blas_get_engine_info(char* buf, size_t len) {
+  const size_t n = library_info(buf, len);
+  void* provider = cblas_provider(NULL);
+  void* set = NULL;
+  const ThreadApi* api = resolve_thread_api(provider, &set);
+  if (provider != RTLD_DEFAULT && provider) dlclose(provider);
+  if (!api || n == 0 || buf[n - 1] != '}') return n;
+  snprintf(buf + n - 1, len - (n - 1), ",\"thread_api\":\"%s\"}", api->name);
+  buf[len - 1] = '\0';
+  return strlen(buf);
+}
+
+BLAS_DEFINE_BACKEND("cblas");
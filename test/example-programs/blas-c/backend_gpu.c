@@ -49,9 +49,8 @@ static void json_escape_str(const char* in, char* out, size_t out_len) {
 
 struct BlasHandle {
   rocblas_handle handle;
-  float *dA, *dB, *dC;
-  size_t szA, szB, szC;
-  int M, N, K;
+  void *dA, *dB, *dC;
+  size_t szA, szB, szC; // allocated bytes
 };
 
 static double now_sec(void) {
@@ -60,13 +59,28 @@ static double now_sec(void) {
   return ts.tv_sec + ts.tv_nsec * 1e-9;
 }
 
+// (Re)allocates a device buffer if it is smaller than `need` bytes
+static int ensure_device_buffer(void** buf, size_t* have, size_t need, const char* what) {
+  if (*have >= need) return 0;
+  if (*buf) { hipFree(*buf); *buf = NULL; *have = 0; }
+  hipError_t st = hipMalloc(buf, need);
+  if (st != hipSuccess) {
+    fprintf(stderr, "HIP hipMalloc(%s) failed: %s\n", what, hipGetErrorString(st));
+    *buf = NULL;
+    return -1;
+  }
+  *have = need;
+  return 0;
+}
+
+// Bytes of a row-major matrix stored with `rows` rows and row stride `ld`
+static size_t stored_bytes(int rows, int ld, BlasPrecision p) {
+  return (size_t)rows * (size_t)ld * blas_precision_size(p);
+}
+
 BlasHandle* blas_init(int M, int N, int K) {
   BlasHandle* h = (BlasHandle*)calloc(1, sizeof(BlasHandle));
   if (!h) return NULL;
-  h->M = M; h->N = N; h->K = K;
-  h->szA = (size_t)M * K * sizeof(float);
-  h->szB = (size_t)K * N * sizeof(float);
-  h->szC = (size_t)M * N * sizeof(float);
 
   rocblas_status rbst = rocblas_create_handle(&h->handle);
   if (rbst != rocblas_status_success) {
@@ -74,80 +88,251 @@ BlasHandle* blas_init(int M, int N, int K) {
     free(h);
     return NULL;
   }
-  hipError_t ha = hipMalloc((void**)&h->dA, h->szA);
-  if (ha != hipSuccess) {
-    fprintf(stderr, "HIP hipMalloc(A) failed: %s\n", hipGetErrorString(ha));
+  // Pre-allocate for the SGEMM hint; blas_gemm() grows the buffers if needed.
+  if (ensure_device_buffer(&h->dA, &h->szA, (size_t)M * K * sizeof(float), "A") != 0 ||
+      ensure_device_buffer(&h->dB, &h->szB, (size_t)K * N * sizeof(float), "B") != 0 ||
+      ensure_device_buffer(&h->dC, &h->szC, (size_t)M * N * sizeof(float), "C") != 0) {
     blas_finalize(h);
     return NULL;
   }
-  hipError_t hb = hipMalloc((void**)&h->dB, h->szB);
-  if (hb != hipSuccess) {
-    fprintf(stderr, "HIP hipMalloc(B) failed: %s\n", hipGetErrorString(hb));
-    blas_finalize(h);
-    return NULL;
+  return h;
+}
+
+static rocblas_operation to_rocblas_op(BlasTranspose t) {
+  switch (t) {
+    case BLAS_OP_T: return rocblas_operation_transpose;
+    case BLAS_OP_C: return rocblas_operation_conjugate_transpose;
+    default:        return rocblas_operation_none;
   }
-  hipError_t hc = hipMalloc((void**)&h->dC, h->szC);
-  if (hc != hipSuccess) {
-    fprintf(stderr, "HIP hipMalloc(C) failed: %s\n", hipGetErrorString(hc));
-    blas_finalize(h);
-    return NULL;
+}
+
+// rocBLAS is column-major: a row-major C is C^T in column-major, and
+// C^T = op(B)^T * op(A)^T, so swap the operands (and M/N) and keep the ops.
+// batch > 0 runs rocblas_?gemm_strided_batched with the given element strides instead.
+static rocblas_status gemm_once(BlasHandle* h, const BlasGemmArgs* g,
+                                int batch, long sA, long sB, long sC) {
+  const rocblas_operation opA = to_rocblas_op(g->transA), opB = to_rocblas_op(g->transB);
+  switch (g->prec) {
+    case BLAS_PREC_S: {
+      const float alpha = (float)g->alpha[0], beta = (float)g->beta[0];
+      if (batch > 0)
+        return rocblas_sgemm_strided_batched(h->handle, opB, opA, g->N, g->M, g->K,
+                                             &alpha, (const float*)h->dB, g->ldb, sB,
+                                             (const float*)h->dA, g->lda, sA,
+                                             &beta, (float*)h->dC, g->ldc, sC, batch);
+      return rocblas_sgemm(h->handle, opB, opA, /* m */ g->N, /* n */ g->M, /* k */ g->K,
+                           &alpha, (const float*)h->dB, g->ldb, (const float*)h->dA, g->lda,
+                           &beta, (float*)h->dC, g->ldc);
+    }
+    case BLAS_PREC_D:
+      if (batch > 0)
+        return rocblas_dgemm_strided_batched(h->handle, opB, opA, g->N, g->M, g->K,
+                                             &g->alpha[0], (const double*)h->dB, g->ldb, sB,
+                                             (const double*)h->dA, g->lda, sA,
+                                             &g->beta[0], (double*)h->dC, g->ldc, sC, batch);
+      return rocblas_dgemm(h->handle, opB, opA, g->N, g->M, g->K,
+                           &g->alpha[0], (const double*)h->dB, g->ldb, (const double*)h->dA, g->lda,
+                           &g->beta[0], (double*)h->dC, g->ldc);
+    case BLAS_PREC_C: {
+      const rocblas_float_complex alpha = { (float)g->alpha[0], (float)g->alpha[1] };
+      const rocblas_float_complex beta  = { (float)g->beta[0],  (float)g->beta[1] };
+      if (batch > 0)
+        return rocblas_cgemm_strided_batched(h->handle, opB, opA, g->N, g->M, g->K,
+                                             &alpha, (const rocblas_float_complex*)h->dB, g->ldb, sB,
+                                             (const rocblas_float_complex*)h->dA, g->lda, sA,
+                                             &beta, (rocblas_float_complex*)h->dC, g->ldc, sC, batch);
+      return rocblas_cgemm(h->handle, opB, opA, g->N, g->M, g->K,
+                           &alpha, (const rocblas_float_complex*)h->dB, g->ldb,
+                           (const rocblas_float_complex*)h->dA, g->lda,
+                           &beta, (rocblas_float_complex*)h->dC, g->ldc);
+    }
+    case BLAS_PREC_Z: {
+      const rocblas_double_complex alpha = { g->alpha[0], g->alpha[1] };
+      const rocblas_double_complex beta  = { g->beta[0],  g->beta[1] };
+      if (batch > 0)
+        return rocblas_zgemm_strided_batched(h->handle, opB, opA, g->N, g->M, g->K,
+                                             &alpha, (const rocblas_double_complex*)h->dB, g->ldb, sB,
+                                             (const rocblas_double_complex*)h->dA, g->lda, sA,
+                                             &beta, (rocblas_double_complex*)h->dC, g->ldc, sC, batch);
+      return rocblas_zgemm(h->handle, opB, opA, g->N, g->M, g->K,
+                           &alpha, (const rocblas_double_complex*)h->dB, g->ldb,
+                           (const rocblas_double_complex*)h->dA, g->lda,
+                           &beta, (rocblas_double_complex*)h->dC, g->ldc);
+    }
   }
-  return h;
+  return rocblas_status_invalid_value;
 }
 
-double blas_sgemm(BlasHandle* h,
-                  const float* A, const float* B, float* C,
-                  int M, int N, int K,
-                  int repeats) {
-  // Sanity: use sizes from init (M,N,K should match)
-  (void)M; (void)N; (void)K;
+// Copies the operands in, runs warmup + timed calls and copies C back (batch == 0: a single GEMM)
+static double gemm_timed(BlasHandle* h, const BlasGemmArgs* args,
+                         const void* A, long sA, const void* B, long sB, void* C, long sC,
+                         int batch, int warmup, int repeats, double* samples) {
+  const size_t esz = blas_precision_size(args->prec);
+  const size_t extra = batch > 1 ? (size_t)(batch - 1) : 0; // matrices after the first
+  const size_t szA = stored_bytes(args->transA == BLAS_OP_N ? args->M : args->K, args->lda, args->prec) + extra * sA * esz;
+  const size_t szB = stored_bytes(args->transB == BLAS_OP_N ? args->K : args->N, args->ldb, args->prec) + extra * sB * esz;
+  const size_t szC = stored_bytes(args->M, args->ldc, args->prec) + extra * sC * esz;
+  if (ensure_device_buffer(&h->dA, &h->szA, szA, "A") != 0 ||
+      ensure_device_buffer(&h->dB, &h->szB, szB, "B") != 0 ||
+      ensure_device_buffer(&h->dC, &h->szC, szC, "C") != 0) {
+    return -1.0;
+  }
 
   hipError_t hst;
-  hst = hipMemcpy(h->dA, A, h->szA, hipMemcpyHostToDevice);
+  hst = hipMemcpy(h->dA, A, szA, hipMemcpyHostToDevice);
   if (hst != hipSuccess) { fprintf(stderr, "HIP Memcpy H2D A failed: %s\n", hipGetErrorString(hst)); return -1.0; }
-  hst = hipMemcpy(h->dB, B, h->szB, hipMemcpyHostToDevice);
+  hst = hipMemcpy(h->dB, B, szB, hipMemcpyHostToDevice);
   if (hst != hipSuccess) { fprintf(stderr, "HIP Memcpy H2D B failed: %s\n", hipGetErrorString(hst)); return -1.0; }
-  hst = hipMemset(h->dC, 0, h->szC);
-  if (hst != hipSuccess) { fprintf(stderr, "HIP Memset C failed: %s\n", hipGetErrorString(hst)); return -1.0; }
-
-  const float alpha = 1.0f, beta = 0.0f;
+  hst = hipMemcpy(h->dC, C, szC, hipMemcpyHostToDevice); // beta may be non-zero
+  if (hst != hipSuccess) { fprintf(stderr, "HIP Memcpy H2D C failed: %s\n", hipGetErrorString(hst)); return -1.0; }
 
   // Warmup
   rocblas_status rb;
-  rb = rocblas_sgemm(h->handle,
-                      rocblas_operation_none, rocblas_operation_none,
-                      /* m */ N, /* n */ M, /* k */ K,
-                      &alpha,
-                      /* A */ h->dB, /* lda */ N,
-                      /* B */ h->dA, /* ldb */ K,
-                      &beta,
-                      /* C */ h->dC, /* ldc */ N);
-  if (rb != rocblas_status_success) { fprintf(stderr, "rocBLAS sgemm warmup failed: status=%d\n", (int)rb); return -1.0; }
+  for (int w = 0; w < warmup; ++w) {
+    rb = gemm_once(h, args, batch, sA, sB, sC);
+    if (rb != rocblas_status_success) { fprintf(stderr, "rocBLAS gemm warmup failed: status=%d\n", (int)rb); return -1.0; }
+  }
   hst = hipDeviceSynchronize();
   if (hst != hipSuccess) { fprintf(stderr, "HIP sync warmup failed: %s\n", hipGetErrorString(hst)); return -1.0; }
 
-  double t0 = now_sec();
+  // Per-call samples need a sync after every call, which costs one launch latency each;
+  // without them the calls are queued back to back.
+  double t0 = now_sec(), t = t0;
   for (int r = 0; r < repeats; ++r) {
-    rb = rocblas_sgemm(h->handle,
-                      rocblas_operation_none, rocblas_operation_none,
-                      /* m */ N, /* n */ M, /* k */ K,
-                      &alpha,
-                      /* A */ h->dB, /* lda */ N,
-                      /* B */ h->dA, /* ldb */ K,
-                      &beta,
-                      /* C */ h->dC, /* ldc */ N);
-    if (rb != rocblas_status_success) { fprintf(stderr, "rocBLAS sgemm failed: status=%d (iter=%d)\n", (int)rb, r); return -1.0; }
+    rb = gemm_once(h, args, batch, sA, sB, sC);
+    if (rb != rocblas_status_success) { fprintf(stderr, "rocBLAS gemm failed: status=%d (iter=%d)\n", (int)rb, r); return -1.0; }
+    if (samples) {
+      hst = hipDeviceSynchronize();
+      if (hst != hipSuccess) { fprintf(stderr, "HIP sync failed: %s\n", hipGetErrorString(hst)); return -1.0; }
+      const double t1 = now_sec();
+      samples[r] = t1 - t;
+      t = t1;
+    }
   }
   hst = hipDeviceSynchronize();
   if (hst != hipSuccess) { fprintf(stderr, "HIP sync failed: %s\n", hipGetErrorString(hst)); return -1.0; }
   double t1 = now_sec();
 
-  hst = hipMemcpy(C, h->dC, h->szC, hipMemcpyDeviceToHost);
+  hst = hipMemcpy(C, h->dC, szC, hipMemcpyDeviceToHost);
   if (hst != hipSuccess) { fprintf(stderr, "HIP Memcpy D2H C failed: %s\n", hipGetErrorString(hst)); return -1.0; }
 
   return t1 - t0;
 }
 
+double blas_gemm(BlasHandle* h, const BlasGemmArgs* args,
+                 const void* A, const void* B, void* C,
+                 int warmup, int repeats, double* samples) {
+  return gemm_timed(h, args, A, 0, B, 0, C, 0, 0, warmup, repeats, samples);
+}
+
+double blas_gemm_strided_batched(BlasHandle* h, const BlasGemmArgs* args,
+                                 const void* A, long strideA, const void* B, long strideB,
+                                 void* C, long strideC,
+                                 int batch, int warmup, int repeats, double* samples) {
+  if (batch <= 0) return 0.0;
+  return gemm_timed(h, args, A, strideA, B, strideB, C, strideC, batch, warmup, repeats, samples);
+}
+
+// Level-1/level-2 kernels on the device buffers: A in dA, x in dB, y in dC.
+// Row-major A (MxN) is column-major A^T, so GEMV/GER/TRSV run on the transpose:
+// y = A*x is A^T^T*x, A += x*y^T is A^T += y*x^T, and lower L is upper L^T.
+// DOT/NRM2 return their scalar to the host (rocBLAS' default pointer mode), which synchronises.
+static rocblas_status vector_once(BlasHandle* h, const BlasVectorArgs* v, double* result) {
+  const int M = v->M, N = v->N;
+  if (v->prec == BLAS_PREC_S) {
+    float* A = (float*)h->dA; float* x = (float*)h->dB; float* y = (float*)h->dC;
+    const float alpha = (float)v->alpha, beta = (float)v->beta;
+    float r = 0.0f;
+    rocblas_status st;
+    switch (v->op) {
+      case BLAS_VEC_AXPY: return rocblas_saxpy(h->handle, N, &alpha, x, 1, y, 1);
+      case BLAS_VEC_DOT:  st = rocblas_sdot(h->handle, N, x, 1, y, 1, &r); *result = r; return st;
+      case BLAS_VEC_NRM2: st = rocblas_snrm2(h->handle, N, x, 1, &r); *result = r; return st;
+      case BLAS_VEC_GEMV: return rocblas_sgemv(h->handle, rocblas_operation_transpose, N, M, &alpha, A, N, x, 1, &beta, y, 1);
+      case BLAS_VEC_GER:  return rocblas_sger(h->handle, N, M, &alpha, y, 1, x, 1, A, N);
+      case BLAS_VEC_TRSV: return rocblas_strsv(h->handle, rocblas_fill_upper, rocblas_operation_transpose,
+                                               rocblas_diagonal_non_unit, N, A, N, x, 1);
+    }
+  } else if (v->prec == BLAS_PREC_D) {
+    double* A = (double*)h->dA; double* x = (double*)h->dB; double* y = (double*)h->dC;
+    switch (v->op) {
+      case BLAS_VEC_AXPY: return rocblas_daxpy(h->handle, N, &v->alpha, x, 1, y, 1);
+      case BLAS_VEC_DOT:  return rocblas_ddot(h->handle, N, x, 1, y, 1, result);
+      case BLAS_VEC_NRM2: return rocblas_dnrm2(h->handle, N, x, 1, result);
+      case BLAS_VEC_GEMV: return rocblas_dgemv(h->handle, rocblas_operation_transpose, N, M, &v->alpha, A, N, x, 1, &v->beta, y, 1);
+      case BLAS_VEC_GER:  return rocblas_dger(h->handle, N, M, &v->alpha, y, 1, x, 1, A, N);
+      case BLAS_VEC_TRSV: return rocblas_dtrsv(h->handle, rocblas_fill_upper, rocblas_operation_transpose,
+                                               rocblas_diagonal_non_unit, N, A, N, x, 1);
+    }
+  }
+  return rocblas_status_invalid_value;
+}
+
+// Sizes (elements) of A, x and y for `v`, see BlasVectorArgs
+static void vector_sizes(const BlasVectorArgs* v, size_t* nA, size_t* nx, size_t* ny) {
+  const size_t M = (size_t)v->M, N = (size_t)v->N;
+  const int level2 = v->op == BLAS_VEC_GEMV || v->op == BLAS_VEC_GER;
+  *nA = level2 ? M * N : v->op == BLAS_VEC_TRSV ? N * N : 0;
+  *nx = v->op == BLAS_VEC_GER ? M : N;
+  *ny = v->op == BLAS_VEC_GEMV ? M : v->op == BLAS_VEC_GER || v->op == BLAS_VEC_AXPY || v->op == BLAS_VEC_DOT ? N : 0;
+}
+
+// Copies A, x and y in, runs warmup + timed calls and copies back what the op writes
+double blas_vector(BlasHandle* h, const BlasVectorArgs* args, void* A, void* x, void* y,
+                   int warmup, int repeats, double* samples, double* result) {
+  if (args->prec != BLAS_PREC_S && args->prec != BLAS_PREC_D) return -1.0;
+  const size_t esz = blas_precision_size(args->prec);
+  size_t nA, nx, ny;
+  vector_sizes(args, &nA, &nx, &ny);
+  if (ensure_device_buffer(&h->dA, &h->szA, (nA ? nA : 1) * esz, "A") != 0 ||
+      ensure_device_buffer(&h->dB, &h->szB, (nx ? nx : 1) * esz, "x") != 0 ||
+      ensure_device_buffer(&h->dC, &h->szC, (ny ? ny : 1) * esz, "y") != 0) {
+    return -1.0;
+  }
+  hipError_t hst = hipSuccess;
+  if (nA && hst == hipSuccess) hst = hipMemcpy(h->dA, A, nA * esz, hipMemcpyHostToDevice);
+  if (nx && hst == hipSuccess) hst = hipMemcpy(h->dB, x, nx * esz, hipMemcpyHostToDevice);
+  if (ny && hst == hipSuccess) hst = hipMemcpy(h->dC, y, ny * esz, hipMemcpyHostToDevice);
+  if (hst != hipSuccess) { fprintf(stderr, "HIP Memcpy H2D failed: %s\n", hipGetErrorString(hst)); return -1.0; }
+
+  double scalar = 0.0;
+  rocblas_status rb;
+  for (int w = 0; w < warmup; ++w) {
+    rb = vector_once(h, args, &scalar);
+    if (rb != rocblas_status_success) { fprintf(stderr, "rocBLAS vector op warmup failed: status=%d\n", (int)rb); return -1.0; }
+  }
+  hst = hipDeviceSynchronize();
+  if (hst != hipSuccess) { fprintf(stderr, "HIP sync warmup failed: %s\n", hipGetErrorString(hst)); return -1.0; }
+
+  double t0 = now_sec(), t = t0;
+  for (int r = 0; r < repeats; ++r) {
+    rb = vector_once(h, args, &scalar);
+    if (rb != rocblas_status_success) { fprintf(stderr, "rocBLAS vector op failed: status=%d (iter=%d)\n", (int)rb, r); return -1.0; }
+    if (samples) {
+      hst = hipDeviceSynchronize();
+      if (hst != hipSuccess) { fprintf(stderr, "HIP sync failed: %s\n", hipGetErrorString(hst)); return -1.0; }
+      const double t1 = now_sec();
+      samples[r] = t1 - t;
+      t = t1;
+    }
+  }
+  hst = hipDeviceSynchronize();
+  if (hst != hipSuccess) { fprintf(stderr, "HIP sync failed: %s\n", hipGetErrorString(hst)); return -1.0; }
+  double t1 = now_sec();
+
+  if (args->op == BLAS_VEC_GER) hst = hipMemcpy(A, h->dA, nA * esz, hipMemcpyDeviceToHost);
+  else if (args->op == BLAS_VEC_TRSV) hst = hipMemcpy(x, h->dB, nx * esz, hipMemcpyDeviceToHost);
+  else if (args->op == BLAS_VEC_AXPY || args->op == BLAS_VEC_GEMV) hst = hipMemcpy(y, h->dC, ny * esz, hipMemcpyDeviceToHost);
+  if (hst != hipSuccess) { fprintf(stderr, "HIP Memcpy D2H failed: %s\n", hipGetErrorString(hst)); return -1.0; }
+  if (result) *result = scalar;
+  return t1 - t0;
+}
+
+int blas_set_num_threads(BlasHandle* h, int n) {
+  (void)h; (void)n;
+  return -1; // not applicable to the GPU
+}
+
 void blas_finalize(BlasHandle* h) {
   if (!h) return;
   if (h->dA) hipFree(h->dA);
@@ -202,4 +387,5 @@ size_t blas_get_engine_info(char* buf, size_t len) {
   }
   buf[len - 1] = '\0';
   return strlen(buf);
-}
\ No newline at end of file
+}
+BLAS_DEFINE_BACKEND("rocblas");
@@ -1,12 +1,81 @@
 #define _GNU_SOURCE 1
 
 #include "backend.h"
+#include "plain_kernels.h"
+#include "plain_fixed.h"
+#include "affinity.h"
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <stdio.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <complex.h>
+#include <math.h>
 
-struct BlasHandle { int dummy; };
+// Blocking in the style of BLIS/GotoBLAS:
+//   KC x NC panel of B is packed once and stays in L3,
+//   MC x KC block of A is packed and stays in L2,
+//   KC x NR sliver of B stays in L1 while the MR x NR micro-kernel runs.
+// The defaults are sized for Zen 2..5 (32 KiB L1D, 512 KiB..1 MiB L2, >=16 MiB L3 per CCX).
+// MC/NC are multiples of every kernel's MR/NR (see plain_kernels.c), so padded blocks still fit.
+#define PLAIN_MC 168   // A block: 168*256*4 = 168 KiB
+#define PLAIN_KC 256   // B sliver: 256*16*4 = 16 KiB
+#define PLAIN_NC 4080  // B panel: 256*4080*4 ~ 4 MiB
+
+// Compiler-vectorised loops (the generic GEMMs, small SGEMM, level 1/2) are built once more for each
+// Zen generation with the withTargetClones stdenv (see helper/my-stenv-adapter.nix), which defines
+// ZEN_TARGET_CLONES. The SGEMM micro-kernels pick their ISA at runtime already (plain_kernels.c).
+#ifdef ZEN_TARGET_CLONE_ARCHS
+#include <zen-target-clones.h>
+#else
+#define ZEN_TARGET_CLONES
+#endif
+
+// Threading:
+//   BLAS_PLAIN_NUM_THREADS  pool size (default: CPUs in the affinity mask)
+//   BLAS_PLAIN_PIN          none (default) | core | spread | ccx
+//     core:   worker w is pinned to one CPU, CPUs ordered by L3 domain
+//     spread: like core, but consecutive workers go round-robin over the L3 domains
+//     ccx:    worker w may run on any CPU of the L3 domain (CCX) it is assigned to
+// Except with spread, workers are numbered so that consecutive ids share an L3 domain; the 2D
+// tiling below gives consecutive ids the same rows of C (same A panel) to keep it in that L3.
+typedef enum { PIN_NONE, PIN_CORE, PIN_SPREAD, PIN_CCX } PinPolicy;
+
+typedef struct PlainWorker {
+  struct BlasHandle* h;
+  int id;
+  pthread_t thread;
+  cpu_set_t cpus;       // affinity applied when pinning is enabled
+  float* packA;         // PLAIN_MC x PLAIN_KC
+  void* packB;          // B panel, grown on demand (floats for SGEMM, any element type otherwise)
+  size_t packB_bytes;
+} PlainWorker;
+
+struct BlasHandle {
+  const PlainKernel* kernel;
+  int use_fixed;        // compile-time size-specialised kernels (plain_fixed.cpp) for their shapes
+  PinPolicy pin;
+  int max_threads;      // pool size
+  int nthreads;         // workers taking part in the next GEMM (<= max_threads)
+  PlainWorker* workers;
+
+  pthread_mutex_t mu;
+  pthread_cond_t cv_start, cv_done;
+  unsigned long generation; // bumped for each dispatched job
+  int pending;              // workers still busy with the current job
+  int shutdown;
+  int failed;               // a worker could not allocate its packing buffers
+
+  // Current job
+  BlasGemmArgs args;
+  const void* A; const void* B; void* C;
+  int grid_rows, grid_cols;
+  int batch;                       // > 0: strided batch of `batch` GEMMs instead of one tiled GEMM
+  long strideA, strideB, strideC;  // in elements
+  plain_fixed_fn fixed;            // batch kernel for this exact shape, NULL if none
+};
 
 static double now_sec(void) {
   struct timespec ts;
@@ -14,56 +83,652 @@ static double now_sec(void) {
   return ts.tv_sec + ts.tv_nsec * 1e-9;
 }
 
+// Pack an mc x kc block of A into MR-high slivers, scaled by alpha.
+// Element (i, k) is read from A[i*rs + k*cs], so transposed A just swaps the strides.
+// Sliver p holds rows [p*MR, p*MR+MR) stored k-major, i.e. packA[p][k][0..MR).
+// Rows beyond mc are zero-padded so the micro-kernel never needs bounds checks.
+static void pack_a(const float* A, size_t rs, size_t cs, int mc, int kc, int MR,
+                   float alpha, float* packA) {
+  for (int i0 = 0; i0 < mc; i0 += MR) {
+    const int mr = (mc - i0 < MR) ? (mc - i0) : MR;
+    for (int k = 0; k < kc; ++k) {
+      int i = 0;
+      for (; i < mr; ++i) packA[i] = alpha * A[(size_t)(i0 + i) * rs + (size_t)k * cs];
+      for (; i < MR; ++i) packA[i] = 0.0f;
+      packA += MR;
+    }
+  }
+}
+
+// Pack a kc x nc panel of B into NR-wide slivers; element (k, j) is read from B[k*rs + j*cs].
+// Sliver q holds columns [q*NR, q*NR+NR) stored k-major, i.e. packB[q][k][0..NR).
+static void pack_b(const float* B, size_t rs, size_t cs, int kc, int nc, int NR, float* packB) {
+  for (int j0 = 0; j0 < nc; j0 += NR) {
+    const int nr = (nc - j0 < NR) ? (nc - j0) : NR;
+    for (int k = 0; k < kc; ++k) {
+      const float* Bk = B + (size_t)k * rs + (size_t)j0 * cs;
+      int j = 0;
+      if (cs == 1) for (; j < nr; ++j) packB[j] = Bk[j];
+      else         for (; j < nr; ++j) packB[j] = Bk[(size_t)j * cs];
+      for (; j < NR; ++j) packB[j] = 0.0f;
+      packB += NR;
+    }
+  }
+}
+
+// Runs the micro-kernel over an mc x nc block of C from packed A/B.
+// Partial edge tiles go through a small scratch tile and are copied out.
+static void macro_kernel(const PlainKernel* kern, int mc, int nc, int kc,
+                         const float* packA, const float* packB,
+                         float* C, size_t ldc, int accumulate) {
+  const int MR = kern->mr, NR = kern->nr;
+  float tile[PLAIN_MAX_MR * PLAIN_MAX_NR] __attribute__((aligned(64)));
+  for (int j0 = 0; j0 < nc; j0 += NR) {
+    const int nr = (nc - j0 < NR) ? (nc - j0) : NR;
+    const float* b = packB + (size_t)j0 * kc;
+    for (int i0 = 0; i0 < mc; i0 += MR) {
+      const int mr = (mc - i0 < MR) ? (mc - i0) : MR;
+      const float* a = packA + (size_t)i0 * kc;
+      float* Cij = C + (size_t)i0 * ldc + j0;
+      if (mr == MR && nr == NR) {
+        kern->ukernel(kc, a, b, Cij, ldc, accumulate);
+      } else {
+        kern->ukernel(kc, a, b, tile, (size_t)NR, 0);
+        for (int i = 0; i < mr; ++i)
+          for (int j = 0; j < nr; ++j) {
+            if (accumulate) Cij[(size_t)i * ldc + j] += tile[i * NR + j];
+            else            Cij[(size_t)i * ldc + j]  = tile[i * NR + j];
+          }
+      }
+    }
+  }
+}
+
+// Blocked SGEMM on the block C[i0..i1) x [j0..j1) of a job:
+// C = alpha * op(A) * op(B) + beta * C, row-major.
+static void sgemm_plain_block(const PlainKernel* kern, float* packA, float* packB,
+                              const BlasGemmArgs* g, const float* A, const float* B, float* C,
+                              int i0, int i1, int j0, int j1) {
+  const size_t lda = (size_t)g->lda, ldb = (size_t)g->ldb, ldc = (size_t)g->ldc;
+  // (row, col) strides of op(A) and op(B) in their storage
+  const size_t a_rs = g->transA == BLAS_OP_N ? lda : 1, a_cs = g->transA == BLAS_OP_N ? 1 : lda;
+  const size_t b_rs = g->transB == BLAS_OP_N ? ldb : 1, b_cs = g->transB == BLAS_OP_N ? 1 : ldb;
+  const float alpha = (float)g->alpha[0], beta = (float)g->beta[0];
+  const int M = i1 - i0, N = j1 - j0, K = g->K;
+  C += (size_t)i0 * ldc + j0;
+
+  // beta == 0 overwrites C in the first K block; otherwise scale once and accumulate
+  if (beta != 0.0f && beta != 1.0f) {
+    for (int i = 0; i < M; ++i)
+      for (int j = 0; j < N; ++j) C[(size_t)i * ldc + j] *= beta;
+  }
+  if (K == 0) {
+    if (beta == 0.0f)
+      for (int i = 0; i < M; ++i) memset(C + (size_t)i * ldc, 0, sizeof(float) * N);
+    return;
+  }
+  for (int jc = 0; jc < N; jc += PLAIN_NC) {
+    const int nc = (N - jc < PLAIN_NC) ? (N - jc) : PLAIN_NC;
+    for (int pc = 0; pc < K; pc += PLAIN_KC) {
+      const int kc = (K - pc < PLAIN_KC) ? (K - pc) : PLAIN_KC;
+      pack_b(B + (size_t)pc * b_rs + (size_t)(j0 + jc) * b_cs, b_rs, b_cs, kc, nc, kern->nr, packB);
+      for (int ic = 0; ic < M; ic += PLAIN_MC) {
+        const int mc = (M - ic < PLAIN_MC) ? (M - ic) : PLAIN_MC;
+        pack_a(A + (size_t)(i0 + ic) * a_rs + (size_t)pc * a_cs, a_rs, a_cs, mc, kc, kern->mr,
+               alpha, packA);
+        macro_kernel(kern, mc, nc, kc, packA, packB,
+                     C + (size_t)ic * ldc + jc, ldc, /* accumulate */ pc > 0 || beta != 0.0f);
+      }
+    }
+  }
+}
+
+// DGEMM/CGEMM/ZGEMM: no hand-written micro-kernels, but the same K/N blocking.
+// op(B) is packed into a contiguous kc x nb panel so the inner j-loop is a
+// unit-stride AXPY the compiler can vectorize, whatever the transposes.
+#define GENERIC_NC 1024
+
+#define SCALAR_REAL(x)    (x)[0]
+#define SCALAR_COMPLEX(x) ((x)[0] + (x)[1] * I)
+#define CONJ_REAL(x)      (x)
+
+#define DEFINE_GEMM_GENERIC(SUF, T, SCALAR, CONJ)                                              \
+ZEN_TARGET_CLONES                                                                              \
+static void SUF##gemm_plain_block(T* panel, const BlasGemmArgs* g,                             \
+                                  const T* A, const T* B, T* C,                                \
+                                  int i0, int i1, int j0, int j1) {                            \
+  const size_t lda = (size_t)g->lda, ldb = (size_t)g->ldb, ldc = (size_t)g->ldc;               \
+  const T alpha = (T)SCALAR(g->alpha), beta = (T)SCALAR(g->beta);                              \
+  const int conjA = g->transA == BLAS_OP_C, conjB = g->transB == BLAS_OP_C;                    \
+  for (int i = i0; i < i1; ++i)                                                                \
+    for (int j = j0; j < j1; ++j)                                                              \
+      C[(size_t)i * ldc + j] = beta == (T)0 ? (T)0 : beta * C[(size_t)i * ldc + j];            \
+  for (int jc = j0; jc < j1; jc += GENERIC_NC) {                                               \
+    const int nb = (j1 - jc < GENERIC_NC) ? (j1 - jc) : GENERIC_NC;                            \
+    for (int pc = 0; pc < g->K; pc += PLAIN_KC) {                                              \
+      const int kc = (g->K - pc < PLAIN_KC) ? (g->K - pc) : PLAIN_KC;                          \
+      for (int k = 0; k < kc; ++k)                                                             \
+        for (int j = 0; j < nb; ++j) {                                                         \
+          T b = g->transB == BLAS_OP_N ? B[(size_t)(pc + k) * ldb + jc + j]                    \
+                                       : B[(size_t)(jc + j) * ldb + pc + k];                   \
+          panel[(size_t)k * nb + j] = conjB ? CONJ(b) : b;                                     \
+        }                                                                                      \
+      for (int i = i0; i < i1; ++i) {                                                          \
+        T* restrict Ci = C + (size_t)i * ldc + jc;                                             \
+        for (int k = 0; k < kc; ++k) {                                                         \
+          T a = g->transA == BLAS_OP_N ? A[(size_t)i * lda + pc + k]                           \
+                                       : A[(size_t)(pc + k) * lda + i];                        \
+          a = alpha * (conjA ? CONJ(a) : a);                                                   \
+          const T* restrict bk = panel + (size_t)k * nb;                                       \
+          for (int j = 0; j < nb; ++j) Ci[j] += a * bk[j];                                     \
+        }                                                                                      \
+      }                                                                                        \
+    }                                                                                          \
+  }                                                                                            \
+}
+
+DEFINE_GEMM_GENERIC(d, double,         SCALAR_REAL,    CONJ_REAL)
+DEFINE_GEMM_GENERIC(c, float complex,  SCALAR_COMPLEX, conjf)
+DEFINE_GEMM_GENERIC(z, double complex, SCALAR_COMPLEX, conj)
+
+// Small SGEMM (M, N, K <= PLAIN_SMALL), as in batches of many tiny matrices: the blocked path's
+// packing into MC x KC / KC x NC buffers and edge-tile copies would cost more than the arithmetic.
+// op(B) is copied once into a zero-padded K x PLAIN_SMALL tile (16 KiB, stays in L1), A is read in
+// place, and each SMALL_MR x SMALL_NR block of C is accumulated in generic vector registers.
+#define PLAIN_SMALL 64
+#define SMALL_MR 4
+#define SMALL_NR 16
+
+// One row of a SMALL_MR x SMALL_NR block; GCC/Clang lower this to zmm, ymm pairs or xmm quads
+typedef float SmallRow __attribute__((vector_size(SMALL_NR * sizeof(float))));
+
+ZEN_TARGET_CLONES
+static void sgemm_small(const BlasGemmArgs* g, const float* A, const float* B, float* C) {
+  float bt[PLAIN_SMALL * PLAIN_SMALL] __attribute__((aligned(64)));
+  const int M = g->M, N = g->N, K = g->K;
+  const int Np = (N + SMALL_NR - 1) / SMALL_NR * SMALL_NR;
+  const size_t ldc = (size_t)g->ldc;
+  // (row, col) strides of op(A) and op(B) in their storage
+  const size_t a_rs = g->transA == BLAS_OP_N ? (size_t)g->lda : 1, a_cs = g->transA == BLAS_OP_N ? 1 : (size_t)g->lda;
+  const size_t b_rs = g->transB == BLAS_OP_N ? (size_t)g->ldb : 1, b_cs = g->transB == BLAS_OP_N ? 1 : (size_t)g->ldb;
+  const float alpha = (float)g->alpha[0], beta = (float)g->beta[0];
+  for (int k = 0; k < K; ++k) {
+    float* bk = bt + k * PLAIN_SMALL;
+    const float* Bk = B + (size_t)k * b_rs;
+    int j = 0;
+    if (b_cs == 1) for (; j < N; ++j) bk[j] = Bk[j];
+    else           for (; j < N; ++j) bk[j] = Bk[(size_t)j * b_cs];
+    for (; j < Np; ++j) bk[j] = 0.0f;
+  }
+  for (int i0 = 0; i0 < M; i0 += SMALL_MR) {
+    // Rows past M repeat the last row (computed, never stored), so A needs no padded copy
+    const float* a[SMALL_MR];
+    for (int r = 0; r < SMALL_MR; ++r) a[r] = A + (size_t)(i0 + r < M ? i0 + r : M - 1) * a_rs;
+    for (int j0 = 0; j0 < N; j0 += SMALL_NR) {
+      SmallRow acc[SMALL_MR] = { { 0.0f } };
+      for (int k = 0; k < K; ++k) {
+        const SmallRow bk = *(const SmallRow*)(bt + k * PLAIN_SMALL + j0);
+        for (int r = 0; r < SMALL_MR; ++r) acc[r] += a[r][(size_t)k * a_cs] * bk;
+      }
+      const int mr = M - i0 < SMALL_MR ? M - i0 : SMALL_MR, nr = N - j0 < SMALL_NR ? N - j0 : SMALL_NR;
+      for (int r = 0; r < mr; ++r) {
+        float* Cr = C + (size_t)(i0 + r) * ldc + j0;
+        if (beta == 0.0f) for (int j = 0; j < nr; ++j) Cr[j] = alpha * acc[r][j];
+        else              for (int j = 0; j < nr; ++j) Cr[j] = alpha * acc[r][j] + beta * Cr[j];
+      }
+    }
+  }
+}
+
+// Splits [0, n) into `parts` ranges aligned to `align`, returns range `idx`.
+static void split_range(int n, int parts, int idx, int align, int* lo, int* hi) {
+  const int units = (n + align - 1) / align;
+  const int base = units / parts, extra = units % parts;
+  int u0 = idx * base + (idx < extra ? idx : extra);
+  int u1 = u0 + base + (idx < extra ? 1 : 0);
+  *lo = u0 * align < n ? u0 * align : n;
+  *hi = u1 * align < n ? u1 * align : n;
+}
+
+// Picks grid_rows x grid_cols == nthreads with tiles as square as possible.
+static void choose_grid(int M, int N, int nthreads, int* rows, int* cols) {
+  int best_r = 1;
+  double best_cost = -1.0;
+  for (int r = 1; r <= nthreads; ++r) {
+    if (nthreads % r != 0) continue;
+    const int c = nthreads / r;
+    const double cost = (double)M / r + (double)N / c; // half-perimeter of one tile
+    if (best_cost < 0.0 || cost < best_cost) { best_cost = cost; best_r = r; }
+  }
+  *rows = best_r;
+  *cols = nthreads / best_r;
+}
+
+static int ensure_packB(PlainWorker* w, size_t bytes) {
+  if (w->packB_bytes >= bytes) return 0;
+  free(w->packB);
+  w->packB = NULL;
+  w->packB_bytes = 0;
+  if (posix_memalign(&w->packB, 64, bytes) != 0) return -1;
+  w->packB_bytes = bytes;
+  return 0;
+}
+
+// Bytes of packed B a worker needs for columns [j0, j1) of a job
+static size_t packB_bytes(const PlainKernel* kern, const BlasGemmArgs* g, int j0, int j1) {
+  if (g->prec == BLAS_PREC_S) {
+    const int nc = (j1 - j0 < PLAIN_NC) ? (j1 - j0) : PLAIN_NC;
+    return sizeof(float) * PLAIN_KC * (size_t)((nc + kern->nr - 1) / kern->nr * kern->nr);
+  }
+  const int nb = (j1 - j0 < GENERIC_NC) ? (j1 - j0) : GENERIC_NC;
+  return blas_precision_size(g->prec) * PLAIN_KC * (size_t)nb;
+}
+
+// C[i0..i1) x [j0..j1) of one GEMM on worker w's packing buffers (sized by the caller)
+static void run_block(PlainWorker* w, const BlasGemmArgs* g, const void* A, const void* B, void* C,
+                      int i0, int i1, int j0, int j1) {
+  switch (g->prec) {
+    case BLAS_PREC_S:
+      sgemm_plain_block(w->h->kernel, w->packA, (float*)w->packB, g,
+                        (const float*)A, (const float*)B, (float*)C, i0, i1, j0, j1);
+      break;
+    case BLAS_PREC_D:
+      dgemm_plain_block((double*)w->packB, g,
+                        (const double*)A, (const double*)B, (double*)C, i0, i1, j0, j1);
+      break;
+    case BLAS_PREC_C:
+      cgemm_plain_block((float complex*)w->packB, g, (const float complex*)A,
+                        (const float complex*)B, (float complex*)C, i0, i1, j0, j1);
+      break;
+    case BLAS_PREC_Z:
+      zgemm_plain_block((double complex*)w->packB, g, (const double complex*)A,
+                        (const double complex*)B, (double complex*)C, i0, i1, j0, j1);
+      break;
+  }
+}
+
+static void worker_run_tile(PlainWorker* w) {
+  BlasHandle* h = w->h;
+  const BlasGemmArgs* g = &h->args;
+  const PlainKernel* kern = h->kernel;
+  const int is_s = g->prec == BLAS_PREC_S;
+  const int r = w->id / h->grid_cols, c = w->id % h->grid_cols;
+  int i0, i1, j0, j1;
+  split_range(g->M, h->grid_rows, r, is_s ? kern->mr : 1, &i0, &i1);
+  split_range(g->N, h->grid_cols, c, is_s ? kern->nr : 8, &j0, &j1);
+  if (i0 >= i1 || j0 >= j1) return;
+
+  if (ensure_packB(w, packB_bytes(kern, g, j0, j1)) != 0) {
+    __atomic_store_n(&h->failed, 1, __ATOMIC_RELAXED);
+    return;
+  }
+  run_block(w, g, h->A, h->B, h->C, i0, i1, j0, j1);
+}
+
+// Batches are split by matrix: each worker runs whole GEMMs of its share on its own,
+// small SGEMMs without any packing.
+static void worker_run_batch(PlainWorker* w) {
+  BlasHandle* h = w->h;
+  const BlasGemmArgs* g = &h->args;
+  const int b0 = (int)((long)h->batch * w->id / h->nthreads);
+  const int b1 = (int)((long)h->batch * (w->id + 1) / h->nthreads);
+  if (b0 >= b1) return;
+
+  const plain_fixed_fn fixed = h->fixed;
+  const int small = g->prec == BLAS_PREC_S &&
+                    g->M <= PLAIN_SMALL && g->N <= PLAIN_SMALL && g->K <= PLAIN_SMALL;
+  if (!fixed && !small && ensure_packB(w, packB_bytes(h->kernel, g, 0, g->N)) != 0) {
+    __atomic_store_n(&h->failed, 1, __ATOMIC_RELAXED);
+    return;
+  }
+  const size_t esz = blas_precision_size(g->prec);
+  for (int i = b0; i < b1; ++i) {
+    const char* A = (const char*)h->A + (size_t)i * h->strideA * esz;
+    const char* B = (const char*)h->B + (size_t)i * h->strideB * esz;
+    char* C = (char*)h->C + (size_t)i * h->strideC * esz;
+    if (fixed) fixed((const float*)A, g->lda, (const float*)B, g->ldb, (float*)C, g->ldc,
+                     (float)g->alpha[0], (float)g->beta[0]);
+    else if (small) sgemm_small(g, (const float*)A, (const float*)B, (float*)C);
+    else run_block(w, g, A, B, C, 0, g->M, 0, g->N);
+  }
+}
+
+static void* worker_main(void* arg) {
+  PlainWorker* w = (PlainWorker*)arg;
+  BlasHandle* h = w->h;
+  if (h->pin != PIN_NONE) {
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &w->cpus);
+  }
+  unsigned long seen = 0;
+  pthread_mutex_lock(&h->mu);
+  for (;;) {
+    while (!h->shutdown && h->generation == seen) pthread_cond_wait(&h->cv_start, &h->mu);
+    if (h->shutdown) break;
+    seen = h->generation;
+    const int active = w->id < h->nthreads;
+    pthread_mutex_unlock(&h->mu);
+
+    if (active) {
+      if (h->batch > 0) worker_run_batch(w);
+      else worker_run_tile(w);
+    }
+
+    pthread_mutex_lock(&h->mu);
+    if (active && --h->pending == 0) pthread_cond_signal(&h->cv_done);
+  }
+  pthread_mutex_unlock(&h->mu);
+  return NULL;
+}
+
+// Runs one GEMM (batch == 0) or one strided batch on the pool and waits for all active workers.
+static int gemm_plain_dispatch(BlasHandle* h, const BlasGemmArgs* args,
+                               const void* A, long strideA, const void* B, long strideB,
+                               void* C, long strideC, int batch) {
+  pthread_mutex_lock(&h->mu);
+  h->args = *args;
+  h->A = A; h->B = B; h->C = C;
+  h->batch = batch;
+  h->strideA = strideA; h->strideB = strideB; h->strideC = strideC;
+  h->fixed = batch > 0 && h->use_fixed ? plain_fixed_lookup(args) : NULL;
+  if (batch == 0) choose_grid(args->M, args->N, h->nthreads, &h->grid_rows, &h->grid_cols);
+  h->pending = h->nthreads;
+  h->failed = 0; // Status of this call only: a later shape may fit where this one didn't
+  h->generation++;
+  pthread_cond_broadcast(&h->cv_start);
+  while (h->pending > 0) pthread_cond_wait(&h->cv_done, &h->mu);
+  const int failed = __atomic_load_n(&h->failed, __ATOMIC_RELAXED);
+  pthread_mutex_unlock(&h->mu);
+  return failed ? -1 : 0;
+}
+
+static int gemm_plain_parallel(BlasHandle* h, const BlasGemmArgs* args,
+                               const void* A, const void* B, void* C) {
+  return gemm_plain_dispatch(h, args, A, 0, B, 0, C, 0, 0);
+}
+
+// One GEMM: a fixed-size kernel runs on the calling thread (far too small to split), anything else on the pool
+static int gemm_plain_one(BlasHandle* h, const BlasGemmArgs* g, plain_fixed_fn fixed,
+                          const void* A, const void* B, void* C) {
+  if (!fixed) return gemm_plain_parallel(h, g, A, B, C);
+  fixed((const float*)A, g->lda, (const float*)B, g->ldb, (float*)C, g->ldc, (float)g->alpha[0], (float)g->beta[0]);
+  return 0;
+}
+
+// Reorders the output of affinity_cpus_by_l3_domain() round-robin over the L3 domains,
+// so the first workers of a smaller team land on different domains.
+static void spread_over_l3_domains(int* order, int n, const int* start, const int* len, int ndom) {
+  int spread[CPU_SETSIZE];
+  int m = 0;
+  for (int k = 0; m < n; ++k) {
+    for (int d = 0; d < ndom; ++d) if (k < len[d]) spread[m++] = order[start[d] + k];
+  }
+  memcpy(order, spread, sizeof(int) * (size_t)n);
+}
+
+// BLAS_PLAIN_FIXED=0 turns the fixed-size kernels off (default: on)
+static int fixed_from_env(void) {
+  const char* s = getenv("BLAS_PLAIN_FIXED");
+  return !(s && strcmp(s, "0") == 0);
+}
+
+static PinPolicy pin_policy_from_env(void) {
+  const char* s = getenv("BLAS_PLAIN_PIN");
+  if (s && strcmp(s, "core") == 0) return PIN_CORE;
+  if (s && strcmp(s, "spread") == 0) return PIN_SPREAD;
+  if (s && strcmp(s, "ccx") == 0) return PIN_CCX;
+  return PIN_NONE;
+}
+
+static const char* pin_policy_name(PinPolicy p) {
+  switch (p) {
+    case PIN_CORE:   return "core";
+    case PIN_SPREAD: return "spread";
+    case PIN_CCX:    return "ccx";
+    default:         return "none";
+  }
+}
+
+static int default_num_threads(void) {
+  const char* s = getenv("BLAS_PLAIN_NUM_THREADS");
+  if (s && atoi(s) > 0) return atoi(s);
+  cpu_set_t allowed;
+  if (sched_getaffinity(0, sizeof allowed, &allowed) == 0 && CPU_COUNT(&allowed) > 0)
+    return CPU_COUNT(&allowed);
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return n > 0 ? (int)n : 1;
+}
+
+// Stops the first `started` workers and releases everything owned by the handle.
+static void plain_destroy(BlasHandle* h, int started) {
+  pthread_mutex_lock(&h->mu);
+  h->shutdown = 1;
+  pthread_cond_broadcast(&h->cv_start);
+  pthread_mutex_unlock(&h->mu);
+  for (int t = 0; t < started; ++t) pthread_join(h->workers[t].thread, NULL);
+  for (int t = 0; t < h->max_threads; ++t) {
+    free(h->workers[t].packA);
+    free(h->workers[t].packB);
+  }
+  pthread_cond_destroy(&h->cv_start);
+  pthread_cond_destroy(&h->cv_done);
+  pthread_mutex_destroy(&h->mu);
+  free(h->workers);
+  free(h);
+}
+
 BlasHandle* blas_init(int M, int N, int K) {
   (void)M; (void)N; (void)K;
   BlasHandle* h = (BlasHandle*)calloc(1, sizeof(BlasHandle));
+  if (!h) return NULL;
+  h->kernel = plain_kernel_select();
+  h->use_fixed = fixed_from_env();
+  h->pin = pin_policy_from_env();
+  h->max_threads = default_num_threads();
+  h->nthreads = h->max_threads;
+  pthread_mutex_init(&h->mu, NULL);
+  pthread_cond_init(&h->cv_start, NULL);
+  pthread_cond_init(&h->cv_done, NULL);
+
+  h->workers = (PlainWorker*)calloc((size_t)h->max_threads, sizeof(PlainWorker));
+  if (!h->workers) { plain_destroy(h, 0); return NULL; }
+
+  int order[CPU_SETSIZE], start[CPU_SETSIZE], len[CPU_SETSIZE];
+  int ndom = 0;
+  const int ncpus = h->pin != PIN_NONE ? affinity_cpus_by_l3_domain(order, start, len, &ndom) : 0;
+  if (h->pin == PIN_SPREAD) spread_over_l3_domains(order, ncpus, start, len, ndom);
+  for (int t = 0; t < h->max_threads; ++t) {
+    PlainWorker* w = &h->workers[t];
+    w->h = h;
+    w->id = t;
+    if (ncpus > 0) {
+      const int cpu = order[t % ncpus];
+      if (h->pin == PIN_CCX) {
+        affinity_l3_domain_of(cpu, &w->cpus);
+      } else {
+        CPU_ZERO(&w->cpus);
+        CPU_SET(cpu, &w->cpus);
+      }
+    }
+    if (posix_memalign((void**)&w->packA, 64, sizeof(float) * PLAIN_MC * PLAIN_KC) != 0) {
+      fprintf(stderr, "PlainC: allocating packing buffers failed\n");
+      plain_destroy(h, 0);
+      return NULL;
+    }
+  }
+  for (int t = 0; t < h->max_threads; ++t) {
+    if (pthread_create(&h->workers[t].thread, NULL, worker_main, &h->workers[t]) != 0) {
+      fprintf(stderr, "PlainC: pthread_create failed for worker %d\n", t);
+      plain_destroy(h, t);
+      return NULL;
+    }
+  }
   return h;
 }
 
-static inline void sgemm_plain_rowmajor(const float* A, const float* B, float* C,
-                                        int M, int N, int K) {
-  // Compute C = A * B with row-major layout, no transposes, alpha=1, beta=0.
-  // A: MxK, B: KxN, C: MxN
-  for (int i = 0; i < M; ++i) {
-    float* Ci = C + (size_t)i * N;
-    const float* Ai = A + (size_t)i * K;
-    for (int j = 0; j < N; ++j) {
-      float sum = 0.0f;
-      for (int k = 0; k < K; ++k) {
-        sum += Ai[k] * B[(size_t)k * N + j];
-      }
-      Ci[j] = sum;
+int blas_set_num_threads(BlasHandle* h, int n) {
+  if (!h) return -1;
+  if (n > 0) h->nthreads = n < h->max_threads ? n : h->max_threads;
+  return h->nthreads;
+}
+
+double blas_gemm(BlasHandle* h, const BlasGemmArgs* args,
+                 const void* A, const void* B, void* C,
+                 int warmup, int repeats, double* samples) {
+  const plain_fixed_fn fixed = h->use_fixed ? plain_fixed_lookup(args) : NULL;
+  // Warmup (not timed); the first call also sizes the workers' packing buffers
+  for (int w = 0; w < warmup; ++w) {
+    if (gemm_plain_one(h, args, fixed, A, B, C) != 0) {
+      fprintf(stderr, "PlainC: a worker failed to allocate its packing buffer\n");
+      return -1.0;
     }
   }
+
+  int failed = 0;
+  double t0 = now_sec(), t = t0;
+  for (int r = 0; r < repeats; ++r) {
+    failed |= gemm_plain_one(h, args, fixed, A, B, C);
+    if (samples) { const double t1 = now_sec(); samples[r] = t1 - t; t = t1; }
+  }
+  double t1 = now_sec();
+  if (failed) {
+    fprintf(stderr, "PlainC: a worker failed to allocate its packing buffer\n");
+    return -1.0;
+  }
+  return t1 - t0;
 }
 
-double blas_sgemm(BlasHandle* h,
-                  const float* A, const float* B, float* C,
-                  int M, int N, int K,
-                  int repeats) {
-  (void)h;
-  // Warmup once (not timed)
-  sgemm_plain_rowmajor(A, B, C, M, N, K);
+double blas_gemm_strided_batched(BlasHandle* h, const BlasGemmArgs* args,
+                                 const void* A, long strideA, const void* B, long strideB,
+                                 void* C, long strideC,
+                                 int batch, int warmup, int repeats, double* samples) {
+  if (batch <= 0) return 0.0;
+  int failed = 0;
+  for (int w = 0; w < warmup; ++w) {
+    failed |= gemm_plain_dispatch(h, args, A, strideA, B, strideB, C, strideC, batch);
+  }
+  double t0 = now_sec(), t = t0;
+  for (int r = 0; r < repeats; ++r) {
+    failed |= gemm_plain_dispatch(h, args, A, strideA, B, strideB, C, strideC, batch);
+    if (samples) { const double t1 = now_sec(); samples[r] = t1 - t; t = t1; }
+  }
+  double t1 = now_sec();
+  if (failed) {
+    fprintf(stderr, "PlainC: a worker failed to allocate its packing buffer\n");
+    return -1.0;
+  }
+  return t1 - t0;
+}
+
+// Level-1/level-2 kernels: plain loops on the calling thread, vectorised by the compiler only
+// (-O3 -march=...), as a reference for what the stdenv flags alone give on memory-bound code.
+// Reductions keep PLAIN_LANES partial sums so they vectorise without -ffast-math.
+#define PLAIN_LANES 16
+
+#define DEFINE_VECTOR_PLAIN(SUF, T)                                                            \
+static T SUF##dot_plain(int n, const T* x, const T* y) {                                       \
+  T acc[PLAIN_LANES] = { 0 };                                                                  \
+  int i = 0;                                                                                   \
+  for (; i + PLAIN_LANES <= n; i += PLAIN_LANES)                                               \
+    for (int l = 0; l < PLAIN_LANES; ++l) acc[l] += x[i + l] * y[i + l];                       \
+  T s = 0;                                                                                     \
+  for (; i < n; ++i) s += x[i] * y[i];                                                         \
+  for (int l = 0; l < PLAIN_LANES; ++l) s += acc[l];                                           \
+  return s;                                                                                    \
+}                                                                                              \
+ZEN_TARGET_CLONES /* SUF##dot_plain is inlined into each clone */                              \
+static int SUF##vector_plain_once(const BlasVectorArgs* v, T* restrict A, T* restrict x,       \
+                                  T* restrict y, double* result) {                             \
+  const int M = v->M, N = v->N;                                                                \
+  const T alpha = (T)v->alpha, beta = (T)v->beta;                                              \
+  switch (v->op) {                                                                             \
+    case BLAS_VEC_AXPY:                                                                        \
+      for (int i = 0; i < N; ++i) y[i] += alpha * x[i];                                        \
+      return 0;                                                                                \
+    case BLAS_VEC_DOT:                                                                         \
+      *result = SUF##dot_plain(N, x, y);                                                       \
+      return 0;                                                                                \
+    case BLAS_VEC_NRM2: /* no rescaling: the benchmark inputs can't overflow */                \
+      *result = sqrt((double)SUF##dot_plain(N, x, x));                                         \
+      return 0;                                                                                \
+    case BLAS_VEC_GEMV:                                                                        \
+      for (int i = 0; i < M; ++i) {                                                            \
+        const T s = alpha * SUF##dot_plain(N, A + (size_t)i * N, x);                           \
+        y[i] = beta == (T)0 ? s : s + beta * y[i];                                             \
+      }                                                                                        \
+      return 0;                                                                                \
+    case BLAS_VEC_GER:                                                                         \
+      for (int i = 0; i < M; ++i) {                                                            \
+        T* restrict Ai = A + (size_t)i * N;                                                    \
+        const T ax = alpha * x[i];                                                             \
+        for (int j = 0; j < N; ++j) Ai[j] += ax * y[j];                                        \
+      }                                                                                        \
+      return 0;                                                                                \
+    case BLAS_VEC_TRSV: /* forward substitution, row by row */                                 \
+      for (int i = 0; i < N; ++i) {                                                            \
+        const T* Ai = A + (size_t)i * N;                                                       \
+        x[i] = (x[i] - SUF##dot_plain(i, Ai, x)) / Ai[i];                                      \
+      }                                                                                        \
+      return 0;                                                                                \
+  }                                                                                            \
+  return -1;                                                                                   \
+}
 
-  double t0 = now_sec();
+DEFINE_VECTOR_PLAIN(s, float)
+DEFINE_VECTOR_PLAIN(d, double)
+
+static int vector_plain_one(const BlasVectorArgs* v, void* A, void* x, void* y, double* result) {
+  switch (v->prec) {
+    case BLAS_PREC_S: return svector_plain_once(v, (float*)A, (float*)x, (float*)y, result);
+    case BLAS_PREC_D: return dvector_plain_once(v, (double*)A, (double*)x, (double*)y, result);
+    default:          return -1;
+  }
+}
+
+double blas_vector(BlasHandle* h, const BlasVectorArgs* args, void* A, void* x, void* y,
+                   int warmup, int repeats, double* samples, double* result) {
+  (void)h;
+  double scalar = 0.0;
+  for (int w = 0; w < warmup; ++w) {
+    if (vector_plain_one(args, A, x, y, &scalar) != 0) return -1.0;
+  }
+  double t0 = now_sec(), t = t0;
   for (int r = 0; r < repeats; ++r) {
-    sgemm_plain_rowmajor(A, B, C, M, N, K);
+    if (vector_plain_one(args, A, x, y, &scalar) != 0) return -1.0;
+    if (samples) { const double t1 = now_sec(); samples[r] = t1 - t; t = t1; }
   }
   double t1 = now_sec();
+  if (result) *result = scalar;
   return t1 - t0;
 }
 
 void blas_finalize(BlasHandle* h) {
-  free(h);
+  if (!h) return;
+  plain_destroy(h, h->max_threads);
 }
 
 size_t blas_get_engine_info(char* buf, size_t len) {
   if (!buf || len == 0) return 0;
-  // Minimal JSON engine descriptor to align with main.c printer
-  const char* s = "{\"name\":\"PlainC\"}";
+  // Minimal JSON engine descriptor to align with main.c printer.
+  // The kernel and threading are what blas_init() will pick on this CPU.
+  // With the withTargetClones stdenv also the clones built in and the one in use.
+  const PlainKernel* kern = plain_kernel_select();
+  char clones[128] = "";
+#ifdef ZEN_TARGET_CLONE_ARCHS
+  snprintf(clones, sizeof clones, ",\"target_clones\":\"%s\",\"target_clone\":\"%s\"",
+           ZEN_TARGET_CLONE_ARCHS, zen_target_clone_selected());
+#endif
+  char s[512];
+  snprintf(s, sizeof s,
+           "{\"name\":\"PlainC\",\"kernel\":\"%s\",\"blocking\":{\"MR\":%d,\"NR\":%d,\"MC\":%d,\"KC\":%d,\"NC\":%d},"
+           "\"threads\":%d,\"pinning\":\"%s\",\"fixed_sizes\":%s%s}",
+           kern->name, kern->mr, kern->nr, PLAIN_MC, PLAIN_KC, PLAIN_NC,
+           default_num_threads(), pin_policy_name(pin_policy_from_env()),
+           fixed_from_env() ? plain_fixed_sizes_json() : "[]", clones);
   size_t n = strlen(s);
   if (n + 1 > len) n = len - 1;
   memcpy(buf, s, n);
   buf[n] = '\0';
   return n;
 }
+
+BLAS_DEFINE_BACKEND("plain");
@@ -5,20 +5,44 @@
 , clr ? null                # GPU: e.g. pkgs.rocmPackages.clr (HIP runtime headers/libs)
 , hipcc ? null              # optional: pkgs.rocmPackages.hipcc
 , pkg-config ? null
+, libpfm ? null             # optional: named events (e.g. AMD FP ops) for --counters
+, pluginBlas ? {}           # CPU: further CBLAS providers built as plugins, e.g. { openblas = pkgs.openblas; }
 , isCpu ? true
 }:
 let
+    pfmFlags = lib.optionalString (libpfm != null) "-DBLAS_HAVE_LIBPFM=1 -lpfm";
+    pluginFlags = "-shared -fPIC -Wl,-Bsymbolic";
+    # Compile-time size-specialised kernels of the plain backend (plain_fixed.hpp); no C++ runtime needed
+    fixedKernelFlags = "-std=c++17 -fno-exceptions -fno-rtti";
+
+    # Backends as dlopen plugins (see backend.h), loaded with `blas-test-c --plugin=...`
+    buildCpuPlugins = ''
+      echo "== CPU backend plugins"
+      mkdir -p build/blas-backends
+      $CXX ${fixedKernelFlags} -fPIC -c -o build/plain_fixed_pic.o plain_fixed.cpp
+      $CC ${pluginFlags} -o build/blas-backends/plain.so backend_plain.c plain_kernels.c affinity.c build/plain_fixed_pic.o -pthread -lm
+    '' + lib.optionalString (blas != null) ''
+      $CC ${pluginFlags} -o build/blas-backends/cblas.so backend_cpu.c $CFLAGS_EXTRA $LDLIBS_EXTRA -ldl
+    '' + lib.concatStrings (lib.mapAttrsToList (name: pkg: ''
+      PLUGIN_CFLAGS="$(PKG_CONFIG_PATH=${lib.getDev pkg}/lib/pkgconfig pkg-config --cflags cblas 2>/dev/null || echo "-I${lib.getDev pkg}/include")"
+      PLUGIN_LIBS="$(PKG_CONFIG_PATH=${lib.getDev pkg}/lib/pkgconfig pkg-config --libs cblas 2>/dev/null || echo "-L${lib.getLib pkg}/lib -lcblas")"
+      $CC ${pluginFlags} -o build/blas-backends/cblas-${name}.so backend_cpu.c $PLUGIN_CFLAGS $PLUGIN_LIBS -ldl
+    '') pluginBlas);
+
     buildCpuBlas = ''
       echo "== CPU build with CBLAS (e.g. amd-blis, OpenBLAS, ...)"
       # Try pkg-config for CBLAS; fall back to common flags if not available.
       CFLAGS_EXTRA="$(pkg-config --cflags cblas 2>/dev/null || true)"
       LDLIBS_EXTRA="$(pkg-config --libs   cblas 2>/dev/null || echo "-lcblas -lblas")"
 
-      $CC -o build/blas-test-cpu main.c backend_cpu.c $CFLAGS_EXTRA $LDLIBS_EXTRA -ldl
+      $CC -o build/blas-test-cpu main.c backend_cpu.c perf_counters.c matrix_alloc.c matrix_fill.c stream.c affinity.c energy.c $CFLAGS_EXTRA $LDLIBS_EXTRA ${pfmFlags} -pthread -ldl -lm
+      ${buildCpuPlugins}
     '';
     buildCpuPlain = ''
       echo "== CPU build (plain)"
-      $CC -o build/blas-test-cpu main.c backend_plain.c -ldl
+      $CXX ${fixedKernelFlags} -c -o build/plain_fixed.o plain_fixed.cpp
+      $CC -o build/blas-test-cpu main.c backend_plain.c plain_kernels.c build/plain_fixed.o perf_counters.c matrix_alloc.c matrix_fill.c stream.c affinity.c energy.c ${pfmFlags} -pthread -ldl -lm
+      ${buildCpuPlugins}
     '';
     buildGpuCc = ''
       echo "== GPU build with rocBLAS C-Compiler"
@@ -28,7 +52,7 @@ let
       echo "HIP_INCLUDES=$HIP_INCLUDES"
       echo "ROCBLAS_INCLUDES=$ROCBLAS_INCLUDES"
 
-      $CC -o build/blas-test-gpu main.c backend_gpu.c $HIP_INCLUDES $ROCBLAS_INCLUDES -L${rocblas}/lib -lrocblas -L${clr}/lib -lamdhip64 -D__HIP_PLATFORM_AMD__=1
+      $CC -o build/blas-test-gpu main.c backend_gpu.c perf_counters.c matrix_alloc.c matrix_fill.c stream.c affinity.c energy.c ${pfmFlags} $HIP_INCLUDES $ROCBLAS_INCLUDES -L${rocblas}/lib -lrocblas -L${clr}/lib -lamdhip64 -D__HIP_PLATFORM_AMD__=1 -pthread -lm
     '';
     buildGpuHip = ''
       echo "== GPU build with rocBLAS/HIP"
@@ -38,9 +62,9 @@ let
                 -I${clr}/include -I${rocblas}/include \
                 -L${rocblas}/lib -lrocblas \
                 -L${clr}/lib -lamdhip64 \
-                -D__HIP_PLATFORM_AMD__=1 \
+                -D__HIP_PLATFORM_AMD__=1 ${pfmFlags} \
                 -o build/blas-test-gpu \
-                main.c backend_gpu.c
+                main.c backend_gpu.c perf_counters.c matrix_alloc.c matrix_fill.c stream.c affinity.c energy.c
     '';
 
     actualBuild =
@@ -53,12 +77,14 @@ stdenv.mkDerivation {
   pname = "blas-test";
   version = "1.0.0";
 
-  src = ./.;  # expects: main.c backend.h backend_cpu.c backend_gpu.c
+  src = ./.;  # expects: main.c backend.h backend_cpu.c backend_gpu.c perf_counters.c matrix_alloc.c matrix_fill.c stream.c affinity.c energy.c plain_kernels.c plain_fixed.{h,hpp,cpp}
 
   nativeBuildInputs = [ pkg-config ];
 
   buildInputs =
-    (if isCpu then [ blas ] else [ rocblas clr ]);
+    (if isCpu then [ blas ] else [ rocblas clr ])
+    ++ lib.optional (libpfm != null) libpfm
+    ++ lib.optionals isCpu (lib.attrValues pluginBlas);
 
   # Name artifact differently so you can install both variants
   # (optional; you can keep a single name if you prefer)
@@ -81,6 +107,8 @@ stdenv.mkDerivation {
     mkdir -p $out/bin
     if [ ${lib.boolToString isCpu} = true ]; then
       install -Dm755 build/blas-test-cpu $out/bin/blas-test-c
+      mkdir -p $out/lib/blas-backends
+      install -m755 build/blas-backends/*.so $out/lib/blas-backends/
     else
       install -Dm755 build/blas-test-gpu $out/bin/blas-test-c
     fi
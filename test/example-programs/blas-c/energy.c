@@ -0,0 +1,95 @@
+#define _GNU_SOURCE 1
+
+#include "energy.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define POWERCAP "/sys/class/powercap"
+
+static double now_sec(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int read_u64(const char* path, unsigned long long* out) {
+  FILE* f = fopen(path, "r");
+  if (!f) return 1;
+  const int ok = fscanf(f, "%llu", out) == 1;
+  fclose(f);
+  return ok ? 0 : 1;
+}
+
+static int read_line(const char* path, char* buf, size_t len) {
+  FILE* f = fopen(path, "r");
+  if (!f) return 1;
+  const int ok = fgets(buf, (int)len, f) != NULL;
+  fclose(f);
+  if (ok) buf[strcspn(buf, "\n")] = '\0';
+  return ok ? 0 : 1;
+}
+
+// Adds zone `dir` if its name maps to a domain and energy_uj can be read
+static void add_zone(EnergyCounters* ec, const char* dir) {
+  char path[160], name[64];
+  unsigned long long value;
+  snprintf(path, sizeof path, "%s/name", dir);
+  if (ec->nzones >= ENERGY_MAX_ZONES || read_line(path, name, sizeof name) != 0) return;
+  EnergyZone* z = &ec->zones[ec->nzones];
+  if (strncmp(name, "package", 7) == 0) z->domain = ENERGY_PACKAGE;
+  else if (strcmp(name, "core") == 0) z->domain = ENERGY_CORE;
+  else if (strcmp(name, "dram") == 0) z->domain = ENERGY_DRAM;
+  else return;
+  snprintf(z->path, sizeof z->path, "%s/energy_uj", dir);
+  if (read_u64(z->path, &value) != 0) return;
+  snprintf(path, sizeof path, "%s/max_energy_range_uj", dir);
+  if (read_u64(path, &z->max_range) != 0) z->max_range = 0;
+  ++ec->nzones;
+}
+
+int energy_open(EnergyCounters* ec) {
+  memset(ec, 0, sizeof *ec);
+  // Packages are intel-rapl:<socket>, their sub-zones (core, dram) intel-rapl:<socket>:<n>
+  char dir[128], name[160];
+  for (int s = 0; s < ENERGY_MAX_ZONES; ++s) {
+    snprintf(dir, sizeof dir, POWERCAP "/intel-rapl:%d", s);
+    snprintf(name, sizeof name, "%s/name", dir);
+    if (access(name, F_OK) != 0) break;
+    add_zone(ec, dir);
+    for (int z = 0; z < ENERGY_MAX_ZONES; ++z) {
+      snprintf(dir, sizeof dir, POWERCAP "/intel-rapl:%d/intel-rapl:%d:%d", s, s, z);
+      snprintf(name, sizeof name, "%s/name", dir);
+      if (access(name, F_OK) != 0) break;
+      add_zone(ec, dir);
+    }
+  }
+  energy_reset(ec);
+  return ec->nzones;
+}
+
+void energy_reset(EnergyCounters* ec) {
+  for (int d = 0; d < ENERGY_DOMAINS; ++d) ec->joules[d] = -1.0;
+  for (int i = 0; i < ec->nzones; ++i) ec->joules[ec->zones[i].domain] = 0.0;
+  ec->secs = 0.0;
+}
+
+void energy_start(EnergyCounters* ec) {
+  for (int i = 0; i < ec->nzones; ++i) {
+    if (read_u64(ec->zones[i].path, &ec->zones[i].start) != 0) ec->zones[i].start = 0;
+  }
+  ec->secs -= now_sec();
+}
+
+void energy_stop(EnergyCounters* ec) {
+  ec->secs += now_sec();
+  for (int i = 0; i < ec->nzones; ++i) {
+    EnergyZone* z = &ec->zones[i];
+    unsigned long long end;
+    if (read_u64(z->path, &end) != 0) continue;
+    const unsigned long long delta = end >= z->start ? end - z->start : end + z->max_range - z->start;
+    ec->joules[z->domain] += delta * 1e-6;
+  }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Energy counters of the RAPL powercap interface (/sys/class/powercap/intel-rapl:*, also used
+// by AMD Zen) around the timed GEMM region. The counters cover the whole package (or core
+// domain), not only this process, and are usually readable by root only.
+
+#define ENERGY_MAX_ZONES 16
+
+typedef enum EnergyDomain { ENERGY_PACKAGE = 0, ENERGY_CORE, ENERGY_DRAM, ENERGY_DOMAINS } EnergyDomain;
+
+typedef struct EnergyZone {
+  char path[160];                 // .../energy_uj
+  EnergyDomain domain;
+  unsigned long long max_range;   // energy_uj wraps around at this value
+  unsigned long long start;       // reading at energy_start()
+} EnergyZone;
+
+typedef struct EnergyCounters {
+  EnergyZone zones[ENERGY_MAX_ZONES];
+  int nzones;                     // readable zones; 0: no energy reported
+  double joules[ENERGY_DOMAINS];  // summed over zones (e.g. sockets) since energy_reset(); < 0: no zone
+  double secs;                    // time between the start/stop pairs since energy_reset()
+} EnergyCounters;
+
+// Finds the readable package, core and DRAM zones; returns the number of zones.
+int energy_open(EnergyCounters* ec);
+
+void energy_reset(EnergyCounters* ec);
+void energy_start(EnergyCounters* ec);
+
+// Adds the energy since the matching energy_start() (wrap-arounds included)
+void energy_stop(EnergyCounters* ec);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,38 +1,156 @@
+#define _GNU_SOURCE 1
+
 #include "backend.h"
+#include "perf_counters.h"
+#include "energy.h"
+#include "matrix_alloc.h"
+#include "matrix_fill.h"
+#include "stream.h"
+#include "affinity.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
+#include <dlfcn.h>
 #include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
 
-static double now_sec(void) {
-  struct timespec ts;
-  clock_gettime(CLOCK_MONOTONIC, &ts);
-  return ts.tv_sec + ts.tv_nsec * 1e-9;
+static void init_matrix(void* M, BlasPrecision prec, size_t count, unsigned seed) {
+  // deterministic fill (multi-threaded LCG, see matrix_fill.c); complex elements take two consecutive values (re, im)
+  const int is_double = prec == BLAS_PREC_D || prec == BLAS_PREC_Z;
+  const size_t scalars = count * ((prec == BLAS_PREC_C || prec == BLAS_PREC_Z) ? 2 : 1);
+  matrix_fill_lcg(M, is_double, scalars, seed);
 }
 
-static void init_matrix(float* M, int rows, int cols, unsigned seed) {
-  // deterministic fill, low overhead
-  unsigned x = seed ? seed : 1u;
-  for (int i = 0; i < rows * cols; ++i) {
-    x = 1664525u * x + 1013904223u;
-    M[i] = ((x >> 8) & 0xFFFF) / 32768.0f - 1.0f;
-  }
+// Sum over all scalars (re and im for complex) of the MxN matrix stored with row stride ld
+static float checksum(const void* M, BlasPrecision prec, int rows, int cols, int ld) {
+  const int is_double = prec == BLAS_PREC_D || prec == BLAS_PREC_Z;
+  const size_t parts = (prec == BLAS_PREC_C || prec == BLAS_PREC_Z) ? 2 : 1;
+  return (float)matrix_sum(M, is_double, rows, (size_t)cols * parts, (size_t)ld * parts);
+}
+
+static const char* precision_name(BlasPrecision p) {
+  static const char* names[] = { "s", "d", "c", "z" };
+  return names[p];
+}
+
+static const char* transpose_name(BlasTranspose t) {
+  static const char* names[] = { "N", "T", "C" };
+  return names[t];
+}
+
+static int is_complex(BlasPrecision p) {
+  return p == BLAS_PREC_C || p == BLAS_PREC_Z;
+}
+
+// Real floating point operations of one GEMM call (a complex multiply-add is 8 flops)
+static double gemm_flops(const BlasGemmArgs* g) {
+  return (is_complex(g->prec) ? 8.0 : 2.0) * (double)g->M * (double)g->N * (double)g->K;
 }
 
-static float checksum(const float* M, int n) {
-  double s = 0.0;
-  for (int i = 0; i < n; ++i) s += M[i];
-  return (float)s;
+// Distribution of the per-call times of one run
+typedef struct TimingStats {
+  int warmup;
+  int samples;
+  double min, median, p90, p99, mean, stddev;
+  double cv;               // stddev / mean
+  double ci95_rel;         // half-width of the 95% confidence interval of the mean, relative to it (< 0: unknown)
+  int outliers;            // samples outside the Tukey fences (1.5 IQR beyond the quartiles)
+  double mean_no_outliers;
+} TimingStats;
+
+static int cmp_double(const void* a, const void* b) {
+  const double x = *(const double*)a, y = *(const double*)b;
+  return (x > y) - (x < y);
+}
+
+// Linear interpolation between the closest ranks of the sorted samples
+static double percentile(const double* sorted, int n, double p) {
+  const double pos = p * (n - 1);
+  const int lo = (int)pos;
+  if (lo + 1 >= n) return sorted[n - 1];
+  return sorted[lo] + (pos - lo) * (sorted[lo + 1] - sorted[lo]);
+}
+
+// Two-sided 95% quantile of Student's t distribution
+static double t95(int df) {
+  static const double table[] = { 0.0,
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+     2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+     2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042 };
+  return df <= 30 ? table[df] : 1.960 + 2.5 / df;
+}
+
+static int timing_stats(const double* samples, int n, int warmup, TimingStats* st) {
+  double* sorted = (double*)malloc((size_t)n * sizeof(double));
+  if (!sorted) return 1;
+  memcpy(sorted, samples, (size_t)n * sizeof(double));
+  qsort(sorted, (size_t)n, sizeof(double), cmp_double);
+
+  double sum = 0.0;
+  for (int i = 0; i < n; ++i) sum += sorted[i];
+  const double mean = sum / n;
+  double var = 0.0;
+  for (int i = 0; i < n; ++i) var += (sorted[i] - mean) * (sorted[i] - mean);
+  var = n > 1 ? var / (n - 1) : 0.0;
+
+  const double q1 = percentile(sorted, n, 0.25), q3 = percentile(sorted, n, 0.75);
+  const double lo = q1 - 1.5 * (q3 - q1), hi = q3 + 1.5 * (q3 - q1);
+  double kept_sum = 0.0;
+  int kept = 0;
+  for (int i = 0; i < n; ++i) {
+    if (sorted[i] >= lo && sorted[i] <= hi) { kept_sum += sorted[i]; ++kept; }
+  }
+
+  st->warmup = warmup;
+  st->samples = n;
+  st->min = sorted[0];
+  st->median = percentile(sorted, n, 0.50);
+  st->p90 = percentile(sorted, n, 0.90);
+  st->p99 = percentile(sorted, n, 0.99);
+  st->mean = mean;
+  st->stddev = sqrt(var);
+  st->cv = mean > 0.0 ? st->stddev / mean : 0.0;
+  st->ci95_rel = n > 1 && mean > 0.0 ? t95(n - 1) * st->stddev / sqrt((double)n) / mean : -1.0;
+  st->outliers = n - kept;
+  st->mean_no_outliers = kept > 0 ? kept_sum / kept : mean;
+  free(sorted);
+  return 0;
 }
 
-static void print_json_results(char* engine, int N, int M, int K, int repeats, char* error, double secs, float checksum) {
-  size_t szA = (size_t)M*K*sizeof(float);
-  size_t szB = (size_t)K*N*sizeof(float);
-  size_t szC = (size_t)M*N*sizeof(float);
+typedef struct Operands {
+  void* A;
+  void* B;
+  void* C;
+  size_t szA, szB, szC;     // bytes, all matrices of a batch
+  MatrixAllocOptions alloc;
+  int batch;                // > 0: strided batch of `batch` GEMMs, stored back to back
+  long strideA, strideB, strideC; // in elements
+} Operands;
+
+typedef struct ScalingPoint {
+  int threads;
+  double secs;
+} ScalingPoint;
+
+static void print_json_results(char* engine, const BlasGemmArgs* g, const Operands* op, int repeats, char* error, double secs, float checksum,
+                               const TimingStats* timing, const PerfCounters* counters, const EnergyCounters* energy,
+                               const ScalingPoint* scaling, int nscaling) {
+  const int M = g->M, N = g->N, K = g->K;
+  const int batch = op && op->batch > 0 ? op->batch : 0;
+  const int nmat = batch > 0 ? batch : 1; // GEMMs per call
+  const size_t esz = blas_precision_size(g->prec);
+  size_t szA = (size_t)M*K*esz*nmat;
+  size_t szB = (size_t)K*N*esz*nmat;
+  size_t szC = (size_t)M*N*esz*nmat;
 
   double total_mb = (szA + szB + szC) / (1024.0 * 1024.0);
   unsigned long long total_bytes = (unsigned long long)(szA + szB + szC);
-  double gflops = (2.0 * (double)M * (double)N * (double)K * repeats) / (secs * 1e9);
+  double flops = gemm_flops(g) * nmat * repeats;
+  double gflops = flops / (secs * 1e9);
 
   printf("{\n");
   printf("  \"engine\": %s,\n", engine);
@@ -41,72 +159,1394 @@ static void print_json_results(char* engine, int N, int M, int K, int repeats, c
   printf("    \"N\": %d,\n", N);
   printf("    \"K\": %d,\n", K);
   printf("    \"repeats\": %d,\n", repeats);
+  if (batch > 0) printf("    \"batch\": %d,\n", batch);
+  printf("    \"precision\": \"%s\",\n", precision_name(g->prec));
+  printf("    \"transA\": \"%s\",\n", transpose_name(g->transA));
+  printf("    \"transB\": \"%s\",\n", transpose_name(g->transB));
+  printf("    \"alpha\": %.6f,\n", g->alpha[0]);
+  printf("    \"beta\": %.6f,\n", g->beta[0]);
+  if (is_complex(g->prec)) {
+    printf("    \"alpha_im\": %.6f,\n", g->alpha[1]);
+    printf("    \"beta_im\": %.6f,\n", g->beta[1]);
+  }
+  printf("    \"lda\": %d,\n", g->lda);
+  printf("    \"ldb\": %d,\n", g->ldb);
+  printf("    \"ldc\": %d,\n", g->ldc);
   printf("    \"expected_bytes_total\": %llu,\n", total_bytes);
-  printf("    \"expected_megabytes_total\": %.1f\n", total_mb);
+  printf("    \"expected_megabytes_total\": %.1f%s\n", total_mb, op ? "," : "");
+  if (op) {
+    const size_t huge = matrix_huge_bytes(op->A, op->szA) + matrix_huge_bytes(op->B, op->szB) +
+                        matrix_huge_bytes(op->C, op->szC);
+    MatrixPages effective = matrix_pages_of(op->A);
+    if (matrix_pages_of(op->B) != effective || matrix_pages_of(op->C) != effective) effective = MATRIX_PAGES_THP;
+    printf("    \"allocation\": {\"pages\": \"%s\", \"pages_effective\": \"%s\", ",
+           matrix_pages_name(op->alloc.pages), matrix_pages_name(effective));
+    if (op->alloc.numa == MATRIX_NUMA_BIND) printf("\"numa\": \"%d\", ", op->alloc.node);
+    else printf("\"numa\": \"%s\", ", op->alloc.numa == MATRIX_NUMA_INTERLEAVE ? "interleave" : "none");
+    printf("\"first_touch\": \"%s\", \"huge_page_bytes\": %zu}\n", op->alloc.parallel_touch ? "parallel" : "serial", huge);
+  }
   printf("  },\n");
   if (error != NULL) {
-    printf("  \"error\": \"%s\"\n", error);
+    printf("  \"error\": \"%s\"%s\n", error, secs > 0.0 ? "," : "");
   }
   if (secs > 0.0) {
     printf("  \"output\": {\n");
     printf("    \"time_sec\": %.6f,\n", secs);
     printf("    \"gflops\": %.2f,\n", gflops);
-    printf("    \"checksum\": %.6f\n", checksum);
+    // Roofline coordinates: flops per compulsory byte (A, B, C once) and the bandwidth that implies
+    printf("    \"arithmetic_intensity\": %.3f,\n", gemm_flops(g) * nmat / (double)total_bytes);
+    printf("    \"bandwidth_gbs\": %.3f,\n", (double)total_bytes * repeats / (secs * 1e9));
+    printf("    \"checksum\": %.6f", checksum);
+    if (batch > 0) {
+      // Throughput and latency of the batched calls, plus the mean cost of one matrix
+      printf(",\n    \"batch\": {\"matrices_per_sec\": %.1f, \"call_latency_sec\": %.9f, \"matrix_latency_sec\": %.9f",
+             (double)batch * repeats / secs, secs / repeats, secs / ((double)batch * repeats));
+      if (timing) printf(", \"call_latency_median_sec\": %.9f, \"call_latency_p99_sec\": %.9f", timing->median, timing->p99);
+      printf("}");
+    }
+    // Optional members below start with the separating comma
+    if (timing) {
+      const double call_flops = gemm_flops(g) * nmat;
+      printf(",\n    \"timing\": {\n");
+      printf("      \"warmup\": %d,\n", timing->warmup);
+      printf("      \"samples\": %d,\n", timing->samples);
+      printf("      \"min_sec\": %.9f,\n", timing->min);
+      printf("      \"median_sec\": %.9f,\n", timing->median);
+      printf("      \"p90_sec\": %.9f,\n", timing->p90);
+      printf("      \"p99_sec\": %.9f,\n", timing->p99);
+      printf("      \"mean_sec\": %.9f,\n", timing->mean);
+      printf("      \"stddev_sec\": %.9f,\n", timing->stddev);
+      printf("      \"cv\": %.4f,\n", timing->cv);
+      if (timing->ci95_rel >= 0.0) printf("      \"ci95_rel\": %.4f,\n", timing->ci95_rel);
+      else                         printf("      \"ci95_rel\": null,\n");
+      printf("      \"outliers\": %d,\n", timing->outliers);
+      printf("      \"mean_sec_no_outliers\": %.9f,\n", timing->mean_no_outliers);
+      printf("      \"gflops_best\": %.2f,\n", call_flops / (timing->min * 1e9));
+      printf("      \"gflops_median\": %.2f\n", call_flops / (timing->median * 1e9));
+      printf("    }");
+    }
+    if (counters) {
+      printf(",\n    \"counters\": {");
+      if (counters->nopen == 0) {
+        printf("\"error\": \"%s\"}", counters->error);
+      } else {
+        const char* sep = "\n";
+        for (int i = 0; i < counters->nevents; ++i) {
+          const PerfEvent* e = &counters->events[i];
+          if (e->nfds == 0) continue;
+          printf("%s      \"%s\": %llu", sep, e->name, e->value);
+          sep = ",\n";
+        }
+        const long long cycles = perf_counters_value(counters, "cycles");
+        const long long instructions = perf_counters_value(counters, "instructions");
+        if (cycles > 0 && instructions >= 0) printf(",\n      \"ipc\": %.3f", (double)instructions / cycles);
+        // Cycles are summed over all threads, so this is per core
+        if (cycles > 0) printf(",\n      \"flops_per_cycle\": %.3f", flops / cycles);
+        if (counters->fp_source[0]) printf(",\n      \"fp_ops_source\": \"%s\"", counters->fp_source);
+        const char* names[2] = { "multiplexed", "unavailable" };
+        for (int k = 0; k < 2; ++k) {
+          printf(",\n      \"%s\": [", names[k]);
+          sep = "";
+          for (int i = 0; i < counters->nevents; ++i) {
+            const PerfEvent* e = &counters->events[i];
+            if (k == 0 ? (e->nfds > 0 && e->multiplexed) : e->nfds == 0) { printf("%s\"%s\"", sep, e->name); sep = ", "; }
+          }
+          printf("]");
+        }
+        printf("\n    }");
+      }
+    }
+    if (energy) {
+      // RAPL energy of the timed calls; the package also includes other processes and idle cores
+      static const char* domains[ENERGY_DOMAINS] = { "package", "core", "dram" };
+      printf(",\n    \"energy\": {");
+      const char* sep = "";
+      for (int d = 0; d < ENERGY_DOMAINS; ++d) {
+        if (energy->joules[d] < 0.0) continue;
+        printf("%s\"%s_joules\": %.3f, \"%s_watts\": %.2f", sep, domains[d], energy->joules[d],
+               domains[d], energy->secs > 0.0 ? energy->joules[d] / energy->secs : 0.0);
+        sep = ", ";
+      }
+      if (energy->joules[ENERGY_PACKAGE] > 0.0) printf(", \"gflops_per_joule\": %.3f", flops * 1e-9 / energy->joules[ENERGY_PACKAGE]);
+      printf("}");
+    }
+    if (nscaling > 0) {
+      // Strong scaling relative to the first (1-thread) point
+      printf(",\n    \"scaling\": [\n");
+      for (int i = 0; i < nscaling; ++i) {
+        double speedup = scaling[0].secs / scaling[i].secs;
+        printf("      {\"threads\": %d, \"time_sec\": %.6f, \"gflops\": %.2f, \"speedup\": %.3f, \"efficiency\": %.3f}%s\n",
+               scaling[i].threads, scaling[i].secs, flops / (scaling[i].secs * 1e9),
+               speedup, speedup * scaling[0].threads / scaling[i].threads, i + 1 < nscaling ? "," : "");
+      }
+      printf("    ]");
+    }
+    printf("\n");
     printf("  }\n");
   }
-  printf("}\n");
+  printf("}");
+}
 
+static void usage(const char* prog) {
+  fprintf(stderr, "Usage: %s [options] [N] [K] [repeats]\n", prog);
+  fprintf(stderr, "  --precision=s|d|c|z     element type (default: s)\n");
+  fprintf(stderr, "  --transa=n|t|c          op(A) (default: n)\n");
+  fprintf(stderr, "  --transb=n|t|c          op(B) (default: n)\n");
+  fprintf(stderr, "  --alpha=RE[,IM]         (default: 1)\n");
+  fprintf(stderr, "  --beta=RE[,IM]          (default: 0)\n");
+  fprintf(stderr, "  --lda=, --ldb=, --ldc=  leading dimensions (default: tight)\n");
+  fprintf(stderr, "  --batch=COUNT           time strided batches of COUNT independent GEMMs (one batched call per repeat)\n");
+  fprintf(stderr, "  --warmup=N              untimed calls before the timed ones (default: 1)\n");
+  fprintf(stderr, "  --target-ci=F           repeat until the 95%% confidence interval of the mean time is within F (e.g. 0.01)\n");
+  fprintf(stderr, "  --max-repeats=N         upper bound on the repeats added by --target-ci (default: 10000)\n");
+  fprintf(stderr, "  --pages=P               default|thp|hugetlb: pages of A, B and C (hugetlb falls back to thp)\n");
+  fprintf(stderr, "  --numa=P                none|interleave|<node>: NUMA placement of A, B and C (mbind)\n");
+  fprintf(stderr, "  --first-touch=P         serial|parallel: parallel touches the pages from one pinned thread per CPU\n");
+  fprintf(stderr, "  --plugin=PATH           run the backend in this shared object instead of the built-in one (repeatable)\n");
+  fprintf(stderr, "  --counters              add hardware performance counters of the timed calls (perf_event_open)\n");
+  fprintf(stderr, "  --thread-sweep          additionally run with 1..T threads (T = backend default) and report scaling\n");
+  fprintf(stderr, "  --bind=P,...            none|close|spread|ccx: thread binding of the BLAS library (OpenMP places,\n");
+  fprintf(stderr, "                          BLAS_PLAIN_PIN); several policies run one after another into one JSON array\n");
+  fprintf(stderr, "  --tenants=P             run P independent callers (own operands and handle each) concurrently and\n");
+  fprintf(stderr, "                          report aggregate throughput, fairness and tail latency\n");
+  fprintf(stderr, "  --tenant-threads=T      library threads per tenant (default: CPUs / P)\n");
+  fprintf(stderr, "  --cold-start            time process start, provider load, blas_init(), the first and later GEMMs separately\n");
+  fprintf(stderr, "  --cold-samples=S        like --cold-start, once in each of S fresh processes (fork + exec)\n");
+  fprintf(stderr, "  --sweep                 run a built-in grid of shapes (N/K only scale the repeats) and print a JSON array\n");
+  fprintf(stderr, "  --shapes=MxNxK,...      like --sweep, but with the given shapes\n");
+  fprintf(stderr, "  --level=1|2|1,2         memory-bound level-1 (axpy,dot,nrm2) / level-2 (gemv,ger,trsv) kernels\n");
+  fprintf(stderr, "                          over a working-set sweep, with a STREAM baseline; precision s or d\n");
+  fprintf(stderr, "  --vector-ops=OP,...     like --level, with any of axpy,dot,nrm2,gemv,ger,trsv\n");
+  fprintf(stderr, "  --working-sets=B,...    working sets for --level, e.g. 32K,1M,256M (default: 16K..4x L3, x4)\n");
+  fprintf(stderr, "  --stream-threads=T      threads of the multi-threaded STREAM baseline (default: all CPUs)\n");
 }
 
-int main(int argc, char** argv) {
-  int N = (argc > 1) ? atoi(argv[1]) : 2048;
-  int K = (argc > 2) ? atoi(argv[2]) : 2048;
-  int repeats = (argc > 3) ? atoi(argv[3]) : 50;
+// Returns the text after "--name=" if `arg` is that option, else NULL
+static const char* opt_value(const char* arg, const char* name) {
+  size_t n = strlen(name);
+  if (strncmp(arg, "--", 2) != 0 || strncmp(arg + 2, name, n) != 0 || arg[2 + n] != '=') return NULL;
+  return arg + 3 + n;
+}
+
+static int parse_transpose(const char* s, BlasTranspose* t) {
+  switch (s[0]) {
+    case 'n': case 'N': *t = BLAS_OP_N; return s[1] == '\0';
+    case 't': case 'T': *t = BLAS_OP_T; return s[1] == '\0';
+    case 'c': case 'C': *t = BLAS_OP_C; return s[1] == '\0';
+    default: return 0;
+  }
+}
+
+static int parse_precision(const char* s, BlasPrecision* p) {
+  switch (s[0]) {
+    case 's': case 'S': *p = BLAS_PREC_S; return s[1] == '\0';
+    case 'd': case 'D': *p = BLAS_PREC_D; return s[1] == '\0';
+    case 'c': case 'C': *p = BLAS_PREC_C; return s[1] == '\0';
+    case 'z': case 'Z': *p = BLAS_PREC_Z; return s[1] == '\0';
+    default: return 0;
+  }
+}
+
+static int parse_scalar(const char* s, double out[2]) {
+  char* end;
+  out[0] = strtod(s, &end);
+  out[1] = 0.0;
+  if (end == s) return 0;
+  if (*end == ',') out[1] = strtod(end + 1, &end);
+  return *end == '\0';
+}
+
+typedef struct TimingOptions {
+  int warmup;
+  double target_ci;   // <= 0: run exactly the requested repeats
+  int max_repeats;
+  PerfCounters* counters; // NULL: no hardware counters
+  EnergyCounters* energy; // NULL: no readable RAPL zone
+} TimingOptions;
+
+// One blas_gemm() or, for batched operands, one blas_gemm_strided_batched() per call
+static double run_gemm(const BlasBackend* be, BlasHandle* h, const BlasGemmArgs* g, const Operands* op,
+                       int warmup, int repeats, double* samples) {
+  if (op->batch > 0)
+    return be->gemm_strided_batched(h, g, op->A, op->strideA, op->B, op->strideB, op->C, op->strideC,
+                                    op->batch, warmup, repeats, samples);
+  return be->gemm(h, g, op->A, op->B, op->C, warmup, repeats, samples);
+}
+
+// Times `*repeats` calls with per-call samples (returned in `*samples`, to be freed by the caller).
+// With a target CI, the number of samples is doubled until the relative 95% confidence interval
+// of the mean is within the target or `max_repeats` is reached; `*repeats` is updated to the total.
+// Hardware counters and RAPL energy (if any) cover exactly the timed calls.
+// Returns the total seconds, negative on failure.
+static double run_timed(const BlasBackend* be, BlasHandle* h, const BlasGemmArgs* g, const Operands* op,
+                        const TimingOptions* t, int* repeats, double** samples) {
+  const int cap = t->target_ci > 0.0 && t->max_repeats > *repeats ? t->max_repeats : *repeats;
+  double* buf = (double*)malloc((size_t)cap * sizeof(double));
+  *samples = buf;
+  if (!buf) return -1.0;
+
+  int n = *repeats;
+  double secs = run_gemm(be, h, g, op, t->warmup, 0, NULL);
+  if (secs < 0.0) return secs;
+  if (t->counters) { perf_counters_reset(t->counters); perf_counters_enable(t->counters); }
+  if (t->energy) { energy_reset(t->energy); energy_start(t->energy); }
+  secs = run_gemm(be, h, g, op, 0, n, buf);
+  if (t->energy) energy_stop(t->energy);
+  if (t->counters) perf_counters_disable(t->counters);
+  while (secs >= 0.0 && n < cap) {
+    TimingStats st;
+    if (timing_stats(buf, n, t->warmup, &st) != 0 || (st.ci95_rel >= 0.0 && st.ci95_rel <= t->target_ci)) break;
+    const int more = cap - n < n ? cap - n : n;
+    if (t->counters) perf_counters_enable(t->counters);
+    if (t->energy) energy_start(t->energy);
+    const double s = run_gemm(be, h, g, op, 0, more, buf + n);
+    if (t->energy) energy_stop(t->energy);
+    if (t->counters) perf_counters_disable(t->counters);
+    secs = s < 0.0 ? s : secs + s;
+    n += more;
+  }
+  if (t->counters) perf_counters_read(t->counters);
+  *repeats = n;
+  return secs;
+}
+
+// Shapes for --sweep: squares (incl. non-powers-of-two), tall-skinny / short-wide,
+// small-K (rank-k updates) and large-K (inner-product-like) cases
+static const int default_sweep_shapes[][3] = {
+  {  256,   256,   256 }, {  512,   512,   512 }, { 1000,  1000,  1000 }, { 1024, 1024, 1024 },
+  { 2048,  2048,  2048 }, { 3000,  3000,  3000 },
+  { 8192,    64,    64 }, {16384,    16,   256 }, {   64,  8192,    64 }, { 100000,  32,   32 },
+  { 2048,  2048,     8 }, { 2048,  2048,    32 }, { 4096,  4096,   128 }, { 4000,  4000,    1 },
+  {   64,    64, 65536 }, {  257,   513,  1031 }, {  999,  1001,   997 }, {   48,    48,   48 },
+};
+
+// (Re-)initializes C (every matrix of a batch), so every backend starts from the same C when beta != 0
+static void reset_output(const BlasGemmArgs* g, Operands* op) {
+  const size_t count = (size_t)g->M * g->ldc * (op->batch > 0 ? op->batch : 1);
+  if (g->beta[0] != 0.0 || g->beta[1] != 0.0) init_matrix(op->C, g->prec, count, 3u);
+  else memset(op->C, 0, count * blas_precision_size(g->prec));
+}
+
+// Checksum of C, over all matrices of a batch
+static float output_checksum(const BlasGemmArgs* g, const Operands* op) {
+  return checksum(op->C, g->prec, g->M * (op->batch > 0 ? op->batch : 1), g->N, g->ldc);
+}
+
+static void free_operands(Operands* op) {
+  matrix_free(op->A); matrix_free(op->B); matrix_free(op->C);
+  op->A = op->B = op->C = NULL;
+}
 
-  if (N <= 0 || K <= 0 || repeats <= 0) {
-    fprintf(stderr, "Usage: %s [N] [K] [repeats]\n", argv[0]);
+// Fills in tight leading dimensions (where unset), allocates (as `aopt` says) and initializes A, B and C for `g`.
+// With batch > 0 there are `batch` of each, stored back to back (the whole batch is filled as one sequence).
+// Returns 0 on success; prints the reason and returns 1 otherwise, with A, B and C freed and NULL.
+static int setup_operands(BlasGemmArgs* g, Operands* op, const MatrixAllocOptions* aopt, int batch) {
+  op->A = op->B = op->C = NULL;
+  const int M = g->M, N = g->N, K = g->K;
+  // Stored shapes: op(A) is MxK, so A is MxK (N) or KxM (T/C); likewise B is KxN or NxK
+  const int rowsA = g->transA == BLAS_OP_N ? M : K, colsA = g->transA == BLAS_OP_N ? K : M;
+  const int rowsB = g->transB == BLAS_OP_N ? K : N, colsB = g->transB == BLAS_OP_N ? N : K;
+  if (g->lda == 0) g->lda = colsA;
+  if (g->ldb == 0) g->ldb = colsB;
+  if (g->ldc == 0) g->ldc = N;
+  if (g->lda < colsA || g->ldb < colsB || g->ldc < N) {
+    fprintf(stderr, "Leading dimensions too small: lda>=%d, ldb>=%d, ldc>=%d required\n", colsA, colsB, N);
     return 1;
   }
 
-  const int M = N; // square by default
-  size_t szA = (size_t)M*K*sizeof(float);
-  size_t szB = (size_t)K*N*sizeof(float);
-  size_t szC = (size_t)M*N*sizeof(float);
+  const size_t esz = blas_precision_size(g->prec);
+  const size_t nmat = batch > 0 ? (size_t)batch : 1;
+  op->batch = batch;
+  op->strideA = (long)rowsA * g->lda;
+  op->strideB = (long)rowsB * g->ldb;
+  op->strideC = (long)M * g->ldc;
+  op->szA = (size_t)op->strideA*esz*nmat;
+  op->szB = (size_t)op->strideB*esz*nmat;
+  op->szC = (size_t)op->strideC*esz*nmat;
+  op->alloc = *aopt;
+
+  if (!(op->A = matrix_alloc(op->szA, aopt))) { perror("alloc A"); return 1; }
+  if (!(op->B = matrix_alloc(op->szB, aopt))) { perror("alloc B"); free_operands(op); return 1; }
+  if (!(op->C = matrix_alloc(op->szC, aopt))) { perror("alloc C"); free_operands(op); return 1; }
+
+  init_matrix(op->A, g->prec, (size_t)op->strideA * nmat, 1u);
+  init_matrix(op->B, g->prec, (size_t)op->strideB * nmat, 2u);
+  reset_output(g, op);
+  return 0;
+}
+
+// Parses "MxNxK,MxNxK,..." into a newly allocated array; returns the number of shapes (0 on error)
+static int parse_shapes(const char* s, int (**out)[3]) {
+  int n = 1;
+  for (const char* p = s; *p; ++p) if (*p == ',') ++n;
+  int (*shapes)[3] = (int (*)[3])calloc((size_t)n, sizeof *shapes);
+  if (!shapes) return 0;
+  for (int i = 0; i < n; ++i) {
+    int used = 0;
+    if (sscanf(s, "%dx%dx%d%n", &shapes[i][0], &shapes[i][1], &shapes[i][2], &used) != 3 ||
+        shapes[i][0] <= 0 || shapes[i][1] <= 0 || shapes[i][2] <= 0 ||
+        (s[used] != ',' && s[used] != '\0')) {
+      free(shapes);
+      return 0;
+    }
+    s += used + (s[used] == ',');
+  }
+  *out = shapes;
+  return n;
+}
 
-  float* A = NULL; float* B = NULL; float* C = NULL;
-  if (posix_memalign((void**)&A, 64, szA) != 0) { perror("alloc A"); return 1; }
-  if (posix_memalign((void**)&B, 64, szB) != 0) { perror("alloc B"); return 1; }
-  if (posix_memalign((void**)&C, 64, szC) != 0) { perror("alloc C"); return 1; }
+// Prints ",\n" before every JSON array element but the first
+static void json_array_sep(int* nitems) {
+  if ((*nitems)++ > 0) printf(",\n");
+}
 
-  init_matrix(A, M, K, 1u);
-  init_matrix(B, K, N, 2u);
-  memset(C, 0, szC);
+// Runs every shape with the options in `tmpl` on backend `be` and prints one JSON array element per shape.
+// Each shape gets enough repeats to do about as much work as `repeats` calls of the
+// reference shape (N x N x K), so small shapes are not lost in timer noise.
+// With batch > 0 every shape runs as a strided batch of that many GEMMs.
+static int run_shape_sweep(const BlasBackend* be, char* eng, const BlasGemmArgs* tmpl,
+                           const int (*shapes)[3], int nshapes,
+                           int refN, int refK, int repeats, int batch, const TimingOptions* topt,
+                           const MatrixAllocOptions* aopt, int* nitems) {
+  int maxM = 1, maxN = 1, maxK = 1;
+  for (int i = 0; i < nshapes; ++i) {
+    if (shapes[i][0] > maxM) maxM = shapes[i][0];
+    if (shapes[i][1] > maxN) maxN = shapes[i][1];
+    if (shapes[i][2] > maxK) maxK = shapes[i][2];
+  }
+  BlasHandle* h = be->init(maxM, maxN, maxK);
+  BlasGemmArgs ref = *tmpl;
+  ref.M = refN; ref.N = refN; ref.K = refK;
+  const double ref_flops = gemm_flops(&ref) * repeats;
 
-  char eng[256];
-  blas_get_engine_info(eng, sizeof eng);
+  int rc = 0;
+  for (int i = 0; i < nshapes; ++i) {
+    BlasGemmArgs g = *tmpl;
+    g.M = shapes[i][0]; g.N = shapes[i][1]; g.K = shapes[i][2];
+    g.lda = g.ldb = g.ldc = 0;
+    double want = ref_flops / (gemm_flops(&g) * (batch > 0 ? batch : 1));
+    int reps = want > 1e6 ? 1000000 : (want < repeats ? repeats : (int)want);
 
-  BlasHandle* h = blas_init(M, N, K);
+    json_array_sep(nitems);
+    Operands op;
+    if (!h) {
+      print_json_results(eng, &g, NULL, reps, "blas_init failed", -1.0, 0.0f, NULL, NULL, NULL, NULL, 0);
+      rc = 2;
+    } else if (setup_operands(&g, &op, aopt, batch) != 0) {
+      print_json_results(eng, &g, NULL, reps, "allocation failed", -1.0, 0.0f, NULL, NULL, NULL, NULL, 0);
+      rc = 1;
+    } else {
+      double* samples = NULL;
+      TimingStats st;
+      double secs = run_timed(be, h, &g, &op, topt, &reps, &samples);
+      if (secs < 0.0) {
+        print_json_results(eng, &g, &op, reps, "gemm failed", -1.0, 0.0f, NULL, NULL, NULL, NULL, 0);
+        rc = 3;
+      } else {
+        const int have_stats = timing_stats(samples, reps, topt->warmup, &st) == 0;
+        print_json_results(eng, &g, &op, reps, NULL, secs, output_checksum(&g, &op),
+                           have_stats ? &st : NULL, topt->counters, topt->energy, NULL, 0);
+      }
+      free(samples);
+      free_operands(&op);
+    }
+    fflush(stdout);
+  }
+  if (h) be->finalize(h);
+  return rc;
+}
+
+// Runs `g` on backend `be` (optionally with a thread sweep) and prints one JSON object.
+// C is reset first, so back-to-back backends all see the same operands.
+static int run_single(const BlasBackend* be, char* eng, const BlasGemmArgs* g, Operands* op,
+                      int repeats, const TimingOptions* topt, int thread_sweep) {
+  reset_output(g, op);
+  BlasHandle* h = be->init(g->M, g->N, g->K);
   if (!h) {
     // Initialization failed: still print JSON result including engine
-    print_json_results(eng, N, M, K, repeats, "blas_init failed", -1.0, 0.0f);
-    free(A); free(B); free(C);
+    print_json_results(eng, g, op, repeats, "blas_init failed", -1.0, 0.0f, NULL, NULL, NULL, NULL, 0);
     return 2;
   }
 
   // Time *just* the GEMM loop; init/finalize are excluded.
-  double secs = blas_sgemm(h, A, B, C, M, N, K, repeats);
+  double* samples = NULL;
+  double secs = run_timed(be, h, g, op, topt, &repeats, &samples);
 
   if (secs < 0.0) {
     // GEMM failed during execution: still print JSON result including engine
-    print_json_results(eng, N, M, K, repeats, "sgemm failed", -1.0, 0.0f);
-    blas_finalize(h);
-    free(A); free(B); free(C);
+    print_json_results(eng, g, op, repeats, "gemm failed", -1.0, 0.0f, NULL, NULL, NULL, NULL, 0);
+    free(samples);
+    be->finalize(h);
     return 3;
-  } else {
-    float csum = checksum(C, M*N);
-    print_json_results(eng, N, M, K, repeats, NULL, secs, csum);
-    blas_finalize(h);
-    free(A); free(B); free(C);
+  }
+  float csum = output_checksum(g, op);
+  TimingStats st;
+  const int have_stats = timing_stats(samples, repeats, topt->warmup, &st) == 0;
+  free(samples);
+
+  ScalingPoint* scaling = NULL;
+  int nscaling = 0;
+  char* error = NULL;
+  const int max_threads = be->set_num_threads(h, 0);
+  if (thread_sweep && max_threads < 0) {
+    error = "thread sweep not supported by backend";
+  } else if (thread_sweep) {
+    scaling = (ScalingPoint*)calloc((size_t)max_threads, sizeof(ScalingPoint));
+    for (int t = 1; scaling && t <= max_threads; ++t) {
+      be->set_num_threads(h, t);
+      double s = run_gemm(be, h, g, op, topt->warmup, repeats, NULL);
+      if (s <= 0.0) { error = "gemm failed during thread sweep"; break; }
+      scaling[nscaling].threads = t;
+      scaling[nscaling].secs = s;
+      ++nscaling;
+    }
+    be->set_num_threads(h, max_threads);
+  }
+
+  print_json_results(eng, g, op, repeats, error, secs, csum, have_stats ? &st : NULL, topt->counters, topt->energy, scaling, nscaling);
+  free(scaling);
+  be->finalize(h);
+  return 0;
+}
+
+// --- Memory-bound level-1/level-2 kernels (--level, --vector-ops) ---
+
+#define VECTOR_OPS 6
+static const char* vector_op_names[VECTOR_OPS] = { "axpy", "dot", "nrm2", "gemv", "ger", "trsv" };
+
+typedef struct VectorOptions {
+  int ops[VECTOR_OPS];           // selected BlasVectorOps
+  size_t* sets;                  // working sets in bytes
+  int nsets;
+  int stream_threads;
+  StreamResult* stream;          // per working set: 1 thread, `stream_threads` threads
+} VectorOptions;
+
+// Sizes for a working set of `bytes`: vectors of N (level 1), M = N for GEMV/GER, and an
+// NxN matrix of which TRSV touches the lower triangle
+static void vector_shape(BlasVectorArgs* v, size_t bytes) {
+  const double e = bytes / (double)blas_precision_size(v->prec); // elements
+  double n;
+  switch (v->op) {
+    case BLAS_VEC_AXPY: case BLAS_VEC_DOT: n = e / 2; break;
+    case BLAS_VEC_NRM2:                    n = e; break;
+    case BLAS_VEC_TRSV:                    n = sqrt(2 * e + 2.25) - 1.5; break; // N(N+1)/2 + N = e
+    default:                               n = sqrt(e + 1) - 1; break;          // N^2 + 2N = e
+  }
+  v->N = n < 1 ? 1 : n > 2e9 ? 2000000000 : (int)n;
+  v->M = v->op == BLAS_VEC_GEMV || v->op == BLAS_VEC_GER ? v->N : 1;
+}
+
+// Elements of A, x and y the op reads or writes at least once (the working set)
+static double vector_footprint(const BlasVectorArgs* v) {
+  const double M = v->M, N = v->N;
+  switch (v->op) {
+    case BLAS_VEC_AXPY: case BLAS_VEC_DOT: return 2 * N;
+    case BLAS_VEC_NRM2:                    return N;
+    case BLAS_VEC_TRSV:                    return N * (N + 1) / 2 + N;
+    default:                               return M * N + M + N;
+  }
+}
+
+// Compulsory memory traffic of one call in elements: every read and every write once
+static double vector_traffic(const BlasVectorArgs* v) {
+  const double M = v->M, N = v->N;
+  switch (v->op) {
+    case BLAS_VEC_AXPY: return 3 * N;                                       // x, y in, y out
+    case BLAS_VEC_DOT:  return 2 * N;
+    case BLAS_VEC_NRM2: return N;
+    case BLAS_VEC_GEMV: return M * N + N + (v->beta != 0.0 ? 2 * M : M);   // y read only if beta != 0
+    case BLAS_VEC_GER:  return 2 * M * N + M + N;                           // A in and out
+    case BLAS_VEC_TRSV: return N * (N + 1) / 2 + 2 * N;                     // x in and out
+  }
+  return 0;
+}
+
+static double vector_flops(const BlasVectorArgs* v) {
+  const double M = v->M, N = v->N;
+  switch (v->op) {
+    case BLAS_VEC_GEMV: case BLAS_VEC_GER: return 2 * M * N;
+    case BLAS_VEC_TRSV:                    return N * N;
+    default:                               return 2 * N;
+  }
+}
+
+// Parses "16K,1M,2G,4096" (binary units) into a newly allocated array; returns the count (0 on error)
+static int parse_sizes(const char* s, size_t** out) {
+  int n = 1;
+  for (const char* p = s; *p; ++p) if (*p == ',') ++n;
+  size_t* sizes = (size_t*)calloc((size_t)n, sizeof *sizes);
+  if (!sizes) return 0;
+  for (int i = 0; i < n; ++i) {
+    char* end;
+    const double v = strtod(s, &end);
+    const int shift = *end == 'K' ? 10 : *end == 'M' ? 20 : *end == 'G' ? 30 : 0;
+    if (shift) ++end;
+    if (end == s || v <= 0 || (*end != ',' && *end != '\0')) { free(sizes); return 0; }
+    sizes[i] = (size_t)(v * (double)((size_t)1 << shift));
+    s = end + (*end == ',');
+  }
+  *out = sizes;
+  return n;
+}
+
+// 16 KiB, 64 KiB, ... up to 4x the L3 of CPU 0, so the sweep ends in DRAM (256 MiB..1 GiB)
+static int default_working_sets(size_t** out) {
+  const size_t lo = (size_t)256 << 20, hi = (size_t)1 << 30;
+  const size_t l3x4 = 4 * stream_cache_size(3);
+  const size_t last = l3x4 < lo ? lo : l3x4 > hi ? hi : l3x4;
+  int n = 0;
+  for (size_t b = (size_t)16 << 10; b <= last; b *= 4) ++n;
+  size_t* sizes = (size_t*)calloc((size_t)n, sizeof *sizes);
+  if (!sizes) return 0;
+  n = 0;
+  for (size_t b = (size_t)16 << 10; b <= last; b *= 4) sizes[n++] = b;
+  *out = sizes;
+  return n;
+}
+
+static int parse_vector_ops(const char* s, int ops[VECTOR_OPS]) {
+  while (*s) {
+    const size_t len = strcspn(s, ",");
+    int found = 0;
+    for (int i = 0; i < VECTOR_OPS; ++i) {
+      if (strlen(vector_op_names[i]) == len && strncmp(s, vector_op_names[i], len) == 0) ops[i] = found = 1;
+    }
+    if (!found) return 0;
+    s += len + (s[len] == ',');
+  }
+  return 1;
+}
+
+// --level=1 selects axpy/dot/nrm2, --level=2 gemv/ger/trsv, --level=1,2 both
+static int parse_level(const char* s, int ops[VECTOR_OPS]) {
+  for (; *s; s += s[1] == ',' ? 2 : 1) {
+    if (*s != '1' && *s != '2') return 0;
+    for (int i = 0; i < VECTOR_OPS; ++i) if ((i >= BLAS_VEC_GEMV) == (*s == '2')) ops[i] = 1;
+    if (s[1] != ',' && s[1] != '\0') return 0;
+  }
+  return 1;
+}
+
+// STREAM copy/triad at every working set, once per run (shared by all backends)
+static int measure_stream_baselines(VectorOptions* vo) {
+  vo->stream = (StreamResult*)calloc((size_t)vo->nsets * 2, sizeof(StreamResult));
+  if (!vo->stream) return 1;
+  for (int i = 0; i < vo->nsets; ++i) {
+    if (stream_measure(vo->sets[i], 1, &vo->stream[2 * i]) != 0 ||
+        stream_measure(vo->sets[i], vo->stream_threads, &vo->stream[2 * i + 1]) != 0) return 1;
   }
   return 0;
 }
+
+static void print_vector_result(const char* engine, const BlasVectorArgs* v, size_t working_set, int repeats,
+                                const char* error, double secs, double checksum, const TimingStats* timing,
+                                const StreamResult* stream) {
+  const double esz = (double)blas_precision_size(v->prec);
+  const double bytes = vector_traffic(v) * esz;
+  printf("{\n");
+  printf("  \"engine\": %s,\n", engine);
+  printf("  \"input\": {\n");
+  printf("    \"op\": \"%s%s\",\n", precision_name(v->prec), vector_op_names[v->op]);
+  printf("    \"precision\": \"%s\",\n", precision_name(v->prec));
+  printf("    \"M\": %d,\n", v->M);
+  printf("    \"N\": %d,\n", v->N);
+  printf("    \"alpha\": %.6f,\n", v->alpha);
+  printf("    \"beta\": %.6f,\n", v->beta);
+  printf("    \"repeats\": %d,\n", repeats);
+  printf("    \"working_set_target_bytes\": %zu,\n", working_set);
+  printf("    \"working_set_bytes\": %.0f,\n", vector_footprint(v) * esz);
+  printf("    \"cache_level\": \"%s\",\n", stream_cache_level((size_t)(vector_footprint(v) * esz)));
+  printf("    \"bytes_per_call\": %.0f\n", bytes);
+  printf("  },\n");
+  if (error != NULL) printf("  \"error\": \"%s\"%s\n", error, secs > 0.0 ? "," : "");
+  if (secs > 0.0) {
+    const double gbs = bytes * repeats / secs * 1e-9;
+    printf("  \"output\": {\n");
+    printf("    \"time_sec\": %.6f,\n", secs);
+    printf("    \"gflops\": %.3f,\n", vector_flops(v) * repeats / secs * 1e-9);
+    printf("    \"bandwidth_gbs\": %.3f,\n", gbs);
+    printf("    \"checksum\": %.6f", checksum);
+    if (timing) {
+      printf(",\n    \"timing\": {\"warmup\": %d, \"samples\": %d, \"min_sec\": %.9f, \"median_sec\": %.9f, "
+             "\"p99_sec\": %.9f, \"cv\": %.4f, \"bandwidth_gbs_best\": %.3f, \"bandwidth_gbs_median\": %.3f}",
+             timing->warmup, timing->samples, timing->min, timing->median, timing->p99, timing->cv,
+             bytes / timing->min * 1e-9, bytes / timing->median * 1e-9);
+    }
+    // Best call against the best STREAM pass, like STREAM itself reports
+    const double best = timing ? bytes / timing->min * 1e-9 : gbs;
+    printf(",\n    \"stream\": {\"threads\": %d, \"copy_gbs\": %.3f, \"triad_gbs\": %.3f, \"copy_gbs_1t\": %.3f, \"triad_gbs_1t\": %.3f}",
+           stream[1].threads, stream[1].copy_gbs, stream[1].triad_gbs, stream[0].copy_gbs, stream[0].triad_gbs);
+    printf(",\n    \"triad_fraction\": %.3f,\n    \"triad_fraction_1t\": %.3f\n",
+           stream[1].triad_gbs > 0.0 ? best / stream[1].triad_gbs : 0.0,
+           stream[0].triad_gbs > 0.0 ? best / stream[0].triad_gbs : 0.0);
+    printf("  }\n");
+  }
+  printf("}");
+}
+
+// Runs one op at one working set: allocates and fills A, x and y, times the calls and prints the result.
+// TRSV solves in place, so x is restored before every call (untimed; repeated solves would underflow).
+static int run_vector_one(const BlasBackend* be, BlasHandle* h, const char* eng, BlasVectorArgs* v,
+                          size_t working_set, int repeats, const TimingOptions* topt,
+                          const MatrixAllocOptions* aopt, const StreamResult* stream) {
+  vector_shape(v, working_set);
+  const size_t esz = blas_precision_size(v->prec);
+  const size_t nA = v->op == BLAS_VEC_TRSV ? (size_t)v->N * v->N : v->op >= BLAS_VEC_GEMV ? (size_t)v->M * v->N : 1;
+  const size_t nv = (size_t)(v->M > v->N ? v->M : v->N);
+  // Enough calls to move about 256 MiB, so cache-sized sets are not lost in timer noise
+  const double want = (double)((size_t)256 << 20) / (vector_traffic(v) * esz);
+  int reps = want > 100000 ? 100000 : want < repeats ? repeats : (int)want;
+  const int is_double = v->prec == BLAS_PREC_D;
+
+  void* A = matrix_alloc(nA * esz, aopt);
+  void* x = matrix_alloc(nv * esz, aopt);
+  void* y = matrix_alloc(nv * esz, aopt);
+  void* x0 = v->op == BLAS_VEC_TRSV ? malloc(nv * esz) : NULL;
+  double* samples = (double*)malloc((size_t)reps * sizeof(double));
+  int rc = 0;
+  if (!A || !x || !y || !samples || (v->op == BLAS_VEC_TRSV && !x0)) {
+    print_vector_result(eng, v, working_set, reps, "allocation failed", -1.0, 0.0, NULL, stream);
+    rc = 1;
+  } else {
+    init_matrix(A, v->prec, nA, 1u);
+    init_matrix(x, v->prec, nv, 2u);
+    init_matrix(y, v->prec, nv, 3u);
+    double secs, result = 0.0;
+    if (v->op == BLAS_VEC_TRSV) {
+      // Diagonal N (off-diagonal entries are in [-1, 1)): well conditioned, and x stays O(1/N)
+      for (int i = 0; i < v->N; ++i) {
+        if (is_double) ((double*)A)[(size_t)i * v->N + i] = v->N;
+        else ((float*)A)[(size_t)i * v->N + i] = (float)v->N;
+      }
+      memcpy(x0, x, nv * esz);
+      secs = 0.0;
+      for (int r = -topt->warmup; r < reps && secs >= 0.0; ++r) {
+        memcpy(x, x0, nv * esz);
+        double t;
+        const double s = be->vector(h, v, A, x, y, 0, 1, &t, &result);
+        secs = s < 0.0 ? s : r >= 0 ? secs + s : secs;
+        if (r >= 0) samples[r] = t;
+      }
+    } else {
+      secs = be->vector(h, v, A, x, y, topt->warmup, reps, samples, &result);
+    }
+    if (secs < 0.0) {
+      print_vector_result(eng, v, working_set, reps, "vector op failed or not supported by backend", -1.0, 0.0, NULL, stream);
+      rc = 3;
+    } else {
+      double csum = result; // DOT, NRM2
+      if (v->op == BLAS_VEC_AXPY || v->op == BLAS_VEC_GEMV) csum = matrix_sum(y, is_double, 1, (size_t)(v->op == BLAS_VEC_GEMV ? v->M : v->N), nv);
+      else if (v->op == BLAS_VEC_GER) csum = matrix_sum(A, is_double, v->M, (size_t)v->N, (size_t)v->N);
+      else if (v->op == BLAS_VEC_TRSV) csum = matrix_sum(x, is_double, 1, (size_t)v->N, nv);
+      TimingStats st;
+      const int have_stats = timing_stats(samples, reps, topt->warmup, &st) == 0;
+      print_vector_result(eng, v, working_set, reps, NULL, secs, csum, have_stats ? &st : NULL, stream);
+    }
+  }
+  matrix_free(A); matrix_free(x); matrix_free(y);
+  free(x0);
+  free(samples);
+  return rc;
+}
+
+// Every selected op at every working set on backend `be`, one JSON array element each
+static int run_vector_sweep(const BlasBackend* be, const char* eng, BlasPrecision prec, const VectorOptions* vo,
+                            int repeats, const TimingOptions* topt, const MatrixAllocOptions* aopt, int* nitems) {
+  BlasHandle* h = be->init(1, 1, 1);
+  int rc = 0;
+  for (int op = 0; op < VECTOR_OPS; ++op) {
+    if (!vo->ops[op]) continue;
+    for (int i = 0; i < vo->nsets; ++i) {
+      BlasVectorArgs v = { (BlasVectorOp)op, prec, 1, 1, 1.0, 0.0 };
+      json_array_sep(nitems);
+      int r;
+      if (!h) {
+        vector_shape(&v, vo->sets[i]);
+        print_vector_result(eng, &v, vo->sets[i], repeats, "blas_init failed", -1.0, 0.0, NULL, &vo->stream[2 * i]);
+        r = 2;
+      } else {
+        r = run_vector_one(be, h, eng, &v, vo->sets[i], repeats, topt, aopt, &vo->stream[2 * i]);
+      }
+      if (rc == 0) rc = r;
+      fflush(stdout);
+    }
+  }
+  if (h) be->finalize(h);
+  return rc;
+}
+
+// --- Multi-tenant contention (--tenants) ---
+
+#define MAX_TENANTS 64
+
+// Start line shared by concurrent tenants: the barrier is set up once the number of running
+// tenants is known (`ready`), so a failed pthread_create can't leave the others waiting
+typedef struct TenantStart {
+  pthread_mutex_t mu;
+  pthread_cond_t cv;
+  int ready;
+  pthread_barrier_t barrier;
+} TenantStart;
+
+// One independent caller: its own operands, BlasHandle and library thread count
+typedef struct Tenant {
+  const BlasBackend* be;
+  BlasGemmArgs g;
+  Operands op;
+  const MatrixAllocOptions* aopt;
+  int threads;                 // library threads requested for this caller
+  int warmup, repeats;
+  TenantStart* start;
+  double* samples;             // per-call seconds
+  double begin, end;           // CLOCK_MONOTONIC around the timed calls
+  float checksum;
+  const char* error;
+  pthread_t thread;
+} Tenant;
+
+static double now_sec(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Sets up everything in the tenant's own thread (so thread-local library state, e.g. the OpenMP
+// team size, belongs to it), then times its calls together with the other tenants.
+static void* tenant_main(void* arg) {
+  Tenant* t = (Tenant*)arg;
+  BlasHandle* h = NULL;
+  t->samples = (double*)malloc((size_t)t->repeats * sizeof(double));
+  if (!t->samples || setup_operands(&t->g, &t->op, t->aopt, 0) != 0) t->error = "allocation failed";
+  else if (!(h = t->be->init(t->g.M, t->g.N, t->g.K))) t->error = "blas_init failed";
+  else if (t->be->set_num_threads(h, t->threads) < 0) t->error = "thread count not supported by backend";
+  else if (run_gemm(t->be, h, &t->g, &t->op, t->warmup, 0, NULL) < 0.0) t->error = "gemm failed";
+
+  pthread_mutex_lock(&t->start->mu);
+  while (!t->start->ready) pthread_cond_wait(&t->start->cv, &t->start->mu);
+  pthread_mutex_unlock(&t->start->mu);
+  pthread_barrier_wait(&t->start->barrier);
+  if (!t->error) {
+    t->begin = now_sec();
+    if (run_gemm(t->be, h, &t->g, &t->op, 0, t->repeats, t->samples) < 0.0) t->error = "gemm failed";
+    t->end = now_sec();
+    t->checksum = output_checksum(&t->g, &t->op);
+  }
+  if (h) t->be->finalize(h);
+  free_operands(&t->op);
+  return NULL;
+}
+
+// Runs `n` tenants concurrently, tenant 0 on the calling thread. Tenants whose thread can't be
+// created get an error and are left out. Returns the first error, NULL if none.
+static const char* run_tenants(Tenant* tenants, int n) {
+  TenantStart start;
+  memset(&start, 0, sizeof start);
+  pthread_mutex_init(&start.mu, NULL);
+  pthread_cond_init(&start.cv, NULL);
+  int started = 1;
+  for (int i = 0; i < n; ++i) tenants[i].start = &start;
+  for (; started < n; ++started) {
+    if (pthread_create(&tenants[started].thread, NULL, tenant_main, &tenants[started]) != 0) break;
+  }
+  for (int i = started; i < n; ++i) tenants[i].error = "pthread_create failed";
+  pthread_mutex_lock(&start.mu);
+  pthread_barrier_init(&start.barrier, NULL, (unsigned)started);
+  start.ready = 1;
+  pthread_cond_broadcast(&start.cv);
+  pthread_mutex_unlock(&start.mu);
+  tenant_main(&tenants[0]);
+  for (int i = 1; i < started; ++i) pthread_join(tenants[i].thread, NULL);
+  pthread_barrier_destroy(&start.barrier);
+  pthread_cond_destroy(&start.cv);
+  pthread_mutex_destroy(&start.mu);
+  for (int i = 0; i < n; ++i) if (tenants[i].error) return tenants[i].error;
+  return NULL;
+}
+
+static void print_tenant_results(const char* engine, const BlasGemmArgs* g, const Tenant* tenants, int n,
+                                 const Tenant* solo, int threads, const char* error) {
+  const double flops = gemm_flops(g);
+  const int cpus = stream_default_threads();
+  printf("{\n");
+  printf("  \"engine\": %s,\n", engine);
+  printf("  \"input\": {\n");
+  printf("    \"M\": %d,\n", g->M);
+  printf("    \"N\": %d,\n", g->N);
+  printf("    \"K\": %d,\n", g->K);
+  printf("    \"repeats\": %d,\n", tenants[0].repeats);
+  printf("    \"precision\": \"%s\",\n", precision_name(g->prec));
+  printf("    \"tenants\": %d,\n", n);
+  printf("    \"threads_per_tenant\": %d,\n", threads);
+  printf("    \"cpus\": %d\n", cpus);
+  printf("  },\n");
+  if (error) {
+    printf("  \"error\": \"%s\"\n", error);
+    printf("}");
+    return;
+  }
+
+  // Aggregate over the window from the first start to the last finish; per tenant over its own calls
+  double first = tenants[0].begin, last = tenants[0].end;
+  int total = 0;
+  for (int i = 0; i < n; ++i) {
+    if (tenants[i].begin < first) first = tenants[i].begin;
+    if (tenants[i].end > last) last = tenants[i].end;
+    total += tenants[i].repeats;
+  }
+  double* all = (double*)malloc((size_t)total * sizeof(double));
+  double sum = 0.0, sum_sq = 0.0, min_g = 0.0, max_g = 0.0, max_lat = 0.0;
+  double* gflops = (double*)malloc((size_t)n * sizeof(double));
+  for (int i = 0, k = 0; i < n; ++i) {
+    gflops[i] = flops * tenants[i].repeats / ((tenants[i].end - tenants[i].begin) * 1e9);
+    sum += gflops[i];
+    sum_sq += gflops[i] * gflops[i];
+    if (i == 0 || gflops[i] < min_g) min_g = gflops[i];
+    if (i == 0 || gflops[i] > max_g) max_g = gflops[i];
+    for (int r = 0; r < tenants[i].repeats; ++r) {
+      if (tenants[i].samples[r] > max_lat) max_lat = tenants[i].samples[r];
+      if (all) all[k++] = tenants[i].samples[r];
+    }
+  }
+  const double wall = last - first;
+  const double aggregate = flops * total / (wall * 1e9);
+  const double solo_gflops = flops * solo->repeats / ((solo->end - solo->begin) * 1e9);
+  TimingStats lat, solo_lat;
+  const int have_lat = all && timing_stats(all, total, 0, &lat) == 0;
+  const int have_solo = timing_stats(solo->samples, solo->repeats, 0, &solo_lat) == 0;
+
+  printf("  \"output\": {\n");
+  printf("    \"wall_sec\": %.6f,\n", wall);
+  printf("    \"gflops_aggregate\": %.2f,\n", aggregate);
+  // One tenant alone with the same thread count; with no contention the aggregate would be n times that
+  printf("    \"gflops_solo\": %.2f,\n", solo_gflops);
+  printf("    \"aggregate_vs_solo\": %.3f,\n", aggregate / solo_gflops);
+  printf("    \"oversubscription\": %.3f,\n", (double)n * threads / cpus);
+  // Jain's index: 1 when every tenant gets the same throughput, 1/n when one gets everything
+  printf("    \"fairness\": {\"jain_index\": %.4f, \"min_max_ratio\": %.4f}", sum * sum / (n * sum_sq), min_g / max_g);
+  if (have_lat && have_solo) {
+    printf(",\n    \"latency\": {\"median_sec\": %.6f, \"p90_sec\": %.6f, \"p99_sec\": %.6f, \"max_sec\": %.6f, "
+           "\"solo_median_sec\": %.6f, \"solo_p99_sec\": %.6f}",
+           lat.median, lat.p90, lat.p99, max_lat, solo_lat.median, solo_lat.p99);
+  }
+  printf(",\n    \"tenants\": [\n");
+  for (int i = 0; i < n; ++i) {
+    TimingStats st;
+    const int ok = timing_stats(tenants[i].samples, tenants[i].repeats, 0, &st) == 0;
+    printf("      {\"gflops\": %.2f, \"median_sec\": %.6f, \"p99_sec\": %.6f, \"checksum\": %.6f}%s\n",
+           gflops[i], ok ? st.median : 0.0, ok ? st.p99 : 0.0, tenants[i].checksum, i + 1 < n ? "," : "");
+  }
+  printf("    ]\n");
+  printf("  }\n");
+  printf("}");
+  free(all);
+  free(gflops);
+}
+
+// Times `g` on backend `be` first as a single tenant, then as `n` concurrent tenants with
+// `threads` library threads each, and prints one JSON object.
+static int run_multi_tenant(const BlasBackend* be, const char* eng, const BlasGemmArgs* g,
+                            const MatrixAllocOptions* aopt, int n, int threads, int repeats, int warmup) {
+  Tenant solo;
+  Tenant* tenants = (Tenant*)calloc((size_t)n, sizeof(Tenant));
+  if (!tenants) return 1;
+  memset(&solo, 0, sizeof solo);
+  solo.be = be;
+  solo.g = *g;
+  solo.aopt = aopt;
+  solo.threads = threads;
+  solo.warmup = warmup;
+  solo.repeats = repeats;
+  for (int i = 0; i < n; ++i) tenants[i] = solo;
+
+  const char* error = run_tenants(&solo, 1);
+  if (!error) error = run_tenants(tenants, n);
+  print_tenant_results(eng, &solo.g, tenants, n, &solo, threads, error);
+  free(solo.samples);
+  for (int i = 0; i < n; ++i) free(tenants[i].samples);
+  free(tenants);
+  return error ? 3 : 0;
+}
+
+#define MAX_PLUGINS 16
+
+// Loads a backend plugin (a shared object exporting BLAS_BACKEND_SYMBOL).
+// RTLD_DEEPBIND makes the plugin resolve cblas_* etc. from its own dependencies first,
+// even if another plugin (or this binary) already loaded a different BLAS.
+static const BlasBackend* load_plugin(const char* path) {
+  void* so = dlopen(path, RTLD_NOW | RTLD_LOCAL | RTLD_DEEPBIND);
+  if (!so) {
+    fprintf(stderr, "Cannot load plugin: %s\n", dlerror());
+    return NULL;
+  }
+  const BlasBackend* be = (const BlasBackend*)dlsym(so, BLAS_BACKEND_SYMBOL);
+  if (!be || be->abi_version != BLAS_BACKEND_ABI_VERSION) {
+    fprintf(stderr, "%s: no compatible %s (ABI %d expected)\n", path, BLAS_BACKEND_SYMBOL, BLAS_BACKEND_ABI_VERSION);
+    dlclose(so);
+    return NULL;
+  }
+  return be; // stays loaded until exit: worker threads may outlive finalize()
+}
+
+// Engine JSON of a backend; for plugins with the plugin's path added, with --bind the policy
+static void engine_info(const BlasBackend* be, const char* plugin, const char* bind, char* eng, size_t len) {
+  char info[512], decorated[640];
+  if (!be) snprintf(info, sizeof info, "{\"name\":\"Unknown\"}");
+  else be->get_engine_info(info, sizeof info);
+  if (bind && info[0] == '{') snprintf(decorated, sizeof decorated, "{\"bind\":\"%s\",%s", bind, info + 1);
+  else snprintf(decorated, sizeof decorated, "%s", info);
+  if (plugin && decorated[0] == '{') snprintf(eng, len, "{\"plugin\":\"%s\",%s", plugin, decorated + 1);
+  else snprintf(eng, len, "%s", decorated);
+}
+
+static void trim_space(char** begin, char** end) {
+  while (*begin < *end && (**begin == ' ' || **begin == '\n')) ++*begin;
+  while (*end > *begin && ((*end)[-1] == ' ' || (*end)[-1] == '\n')) --*end;
+}
+
+// Runs this program once per binding policy (same arguments, --bind=<policy>) and prints
+// the results of all runs as one JSON array. Every run is a fresh process, because the
+// OpenMP runtimes fix their binding when they are loaded. Returns the first non-zero exit code.
+static int run_bind_sweep(int argc, char** argv, const AffinityPolicy* binds, int nbinds) {
+  char** child_argv = (char**)calloc((size_t)argc + 1, sizeof(char*));
+  char bind_arg[32];
+  if (!child_argv) return 1;
+  int rc = 0, nitems = 0;
+  printf("[\n");
+  for (int b = 0; b < nbinds; ++b) {
+    snprintf(bind_arg, sizeof bind_arg, "--bind=%s", affinity_policy_name(binds[b]));
+    for (int i = 0; i < argc; ++i) child_argv[i] = opt_value(argv[i], "bind") ? bind_arg : argv[i];
+    int fds[2];
+    if (pipe(fds) != 0) { rc = rc ? rc : 1; break; }
+    fflush(stdout);
+    const pid_t pid = fork();
+    if (pid == 0) {
+      close(fds[0]);
+      dup2(fds[1], STDOUT_FILENO);
+      close(fds[1]);
+      if (affinity_apply_env(binds[b]) == 0) execv("/proc/self/exe", child_argv);
+      _exit(127);
+    }
+    close(fds[1]);
+    // Collect the child's JSON: an object, or an array whose elements are spliced in
+    size_t len = 0, cap = 1 << 16;
+    char* out = (char*)malloc(cap);
+    ssize_t got;
+    while (out && (got = read(fds[0], out + len, cap - len - 1)) > 0) {
+      len += (size_t)got;
+      if (len + 1 < cap) continue;
+      char* grown = (char*)realloc(out, cap *= 2);
+      if (!grown) free(out);
+      out = grown;
+    }
+    close(fds[0]);
+    int status = 0;
+    if (pid > 0) waitpid(pid, &status, 0);
+    const int r = pid < 0 || !WIFEXITED(status) ? 1 : WEXITSTATUS(status);
+    if (rc == 0) rc = r;
+    if (!out) { rc = rc ? rc : 1; continue; }
+    out[len] = '\0';
+    char* begin = out;
+    char* end = out + len;
+    trim_space(&begin, &end);
+    if (end > begin && *begin == '[' && end[-1] == ']') {
+      ++begin; --end;
+      trim_space(&begin, &end);
+    }
+    if (end > begin) {
+      json_array_sep(&nitems);
+      fwrite(begin, 1, (size_t)(end - begin), stdout);
+    }
+    free(out);
+  }
+  printf("\n]\n");
+  free(child_argv);
+  return rc;
+}
+
+// --- Cold start (--cold-start, --cold-samples) ---
+
+// Seconds and minor page faults of each start-up phase of one process.
+// exec_to_main covers the kernel's exec, the dynamic linker loading and relocating every DT_NEEDED
+// library (the BLAS provider of the built-in backend among them) and their constructors.
+typedef enum ColdPhase {
+  COLD_EXEC_TO_MAIN = 0,  // from the parent's execv() (or, without one, the process start time in /proc)
+  COLD_PROVIDER_LOAD,     // dlopen() of a --plugin and its BLAS library; 0 for the built-in backend
+  COLD_OPERANDS,          // allocating and filling A, B and C (their first-touch page faults)
+  COLD_INIT,              // blas_init()
+  COLD_FIRST_CALL,        // first GEMM: library context, thread pool spawn, packing buffers
+  COLD_SECOND_CALL,
+  COLD_STEADY_CALL,       // median of the remaining calls
+  COLD_FIRST_RESULT,      // exec (or process start) to the end of the first GEMM
+  COLD_PHASES
+} ColdPhase;
+
+static const char* cold_phase_names[COLD_PHASES] = {
+  "exec_to_main", "provider_load", "operands", "init", "first_call", "second_call", "steady_call", "time_to_first_result"
+};
+
+typedef struct ColdTimeline {
+  double secs[COLD_PHASES];
+  long faults[COLD_PHASES];  // minor page faults, all threads (getrusage); per call for steady_call
+  int failed;
+} ColdTimeline;
+
+static long minor_faults(void) {
+  struct rusage ru;
+  return getrusage(RUSAGE_SELF, &ru) == 0 ? ru.ru_minflt : 0;
+}
+
+// CLOCK_MONOTONIC at the parent's execv() (BLAS_COLD_T0), else the process start time from
+// /proc/self/stat (clock ticks since boot, so only 1/CLK_TCK resolution) mapped onto CLOCK_MONOTONIC
+static double process_start_sec(void) {
+  const char* t0 = getenv("BLAS_COLD_T0");
+  if (t0) return atof(t0);
+  char buf[1024];
+  FILE* f = fopen("/proc/self/stat", "r");
+  if (!f) return -1.0;
+  const size_t n = fread(buf, 1, sizeof buf - 1, f);
+  fclose(f);
+  buf[n] = '\0';
+  // Field 22; counting starts after the command name, which may contain spaces
+  const char* p = strrchr(buf, ')');
+  unsigned long long start_ticks = 0;
+  for (int field = 2; p && field < 22; ++field) p = strchr(p + 1, ' ');
+  if (!p || sscanf(p + 1, "%llu", &start_ticks) != 1) return -1.0;
+  struct timespec boot, mono;
+  clock_gettime(CLOCK_BOOTTIME, &boot);
+  clock_gettime(CLOCK_MONOTONIC, &mono);
+  const double since_start = (boot.tv_sec + boot.tv_nsec * 1e-9) - (double)start_ticks / sysconf(_SC_CLK_TCK);
+  return mono.tv_sec + mono.tv_nsec * 1e-9 - since_start;
+}
+
+// Goes through the start-up phases once in this process: loads `plugin` (NULL: built-in backend),
+// sets up the operands, initializes the backend and times the first `repeats` GEMMs one by one.
+static void cold_start_once(const char* plugin, BlasGemmArgs* g, const MatrixAllocOptions* aopt,
+                            int repeats, double main_sec, ColdTimeline* tl) {
+  memset(tl, 0, sizeof *tl);
+  const double start = process_start_sec();
+  tl->secs[COLD_EXEC_TO_MAIN] = start >= 0.0 ? main_sec - start : -1.0;
+
+  long faults = minor_faults();
+  double t = now_sec();
+  const BlasBackend* be = &blas_backend;
+  if (plugin && !(be = load_plugin(plugin))) { tl->failed = 1; return; }
+  const double t_load = now_sec();
+  tl->secs[COLD_PROVIDER_LOAD] = t_load - t;
+  tl->faults[COLD_PROVIDER_LOAD] = minor_faults() - faults;
+
+  Operands op;
+  memset(&op, 0, sizeof op);
+  faults = minor_faults();
+  if (setup_operands(g, &op, aopt, 0) != 0) { tl->failed = 1; return; }
+  t = now_sec();
+  tl->secs[COLD_OPERANDS] = t - t_load;
+  tl->faults[COLD_OPERANDS] = minor_faults() - faults;
+
+  faults = minor_faults();
+  BlasHandle* h = be->init(g->M, g->N, g->K);
+  if (!h) { tl->failed = 1; free_operands(&op); return; }
+  tl->secs[COLD_INIT] = now_sec() - t;
+  tl->faults[COLD_INIT] = minor_faults() - faults;
+
+  double* samples = (double*)malloc((size_t)repeats * sizeof(double));
+  long* call_faults = (long*)malloc((size_t)repeats * sizeof(long));
+  for (int r = 0; samples && call_faults && r < repeats && !tl->failed; ++r) {
+    faults = minor_faults();
+    samples[r] = run_gemm(be, h, g, &op, 0, 1, NULL);
+    call_faults[r] = minor_faults() - faults;
+    if (samples[r] < 0.0) tl->failed = 1;
+    if (r == 0) tl->secs[COLD_FIRST_RESULT] = start >= 0.0 ? now_sec() - start : -1.0;
+  }
+  if (!samples || !call_faults) tl->failed = 1;
+  if (!tl->failed) {
+    tl->secs[COLD_FIRST_CALL] = samples[0];
+    tl->faults[COLD_FIRST_CALL] = call_faults[0];
+    tl->secs[COLD_SECOND_CALL] = samples[1];
+    tl->faults[COLD_SECOND_CALL] = call_faults[1];
+    TimingStats st;
+    long steady_faults = 0;
+    for (int r = 2; r < repeats; ++r) steady_faults += call_faults[r];
+    tl->secs[COLD_STEADY_CALL] = timing_stats(samples + 2, repeats - 2, 0, &st) == 0 ? st.median : -1.0;
+    tl->faults[COLD_STEADY_CALL] = steady_faults / (repeats - 2);
+  }
+  free(samples);
+  free(call_faults);
+  be->finalize(h);
+  free_operands(&op);
+}
+
+// Runs cold_start_once() in `samples` fresh processes (this program re-executed with --cold-start),
+// each reporting its timeline through a pipe. Returns the number of timelines collected.
+static int cold_start_children(char** argv, int argc, ColdTimeline* out, int samples) {
+  char** child_argv = (char**)calloc((size_t)argc + 1, sizeof(char*));
+  if (!child_argv) return 0;
+  for (int i = 0; i < argc; ++i) child_argv[i] = opt_value(argv[i], "cold-samples") ? (char*)"--cold-start" : argv[i];
+  int n = 0;
+  for (int s = 0; s < samples; ++s) {
+    int fds[2];
+    if (pipe(fds) != 0) break;
+    fflush(stdout);
+    const pid_t pid = fork();
+    if (pid == 0) {
+      close(fds[0]);
+      char fd[16], t0[32];
+      snprintf(fd, sizeof fd, "%d", fds[1]);
+      setenv("BLAS_COLD_FD", fd, 1);
+      snprintf(t0, sizeof t0, "%.9f", now_sec());
+      setenv("BLAS_COLD_T0", t0, 1);
+      execv("/proc/self/exe", child_argv);
+      _exit(127);
+    }
+    close(fds[1]);
+    ColdTimeline tl;
+    const int got = pid > 0 && read(fds[0], &tl, sizeof tl) == (ssize_t)sizeof tl;
+    close(fds[0]);
+    if (pid > 0) waitpid(pid, NULL, 0);
+    if (got && !tl.failed) out[n++] = tl;
+  }
+  free(child_argv);
+  return n;
+}
+
+static void print_cold_results(const char* engine, const BlasGemmArgs* g, int repeats,
+                               const ColdTimeline* tl, int n, int requested, const char* error) {
+  printf("{\n");
+  printf("  \"engine\": %s,\n", engine);
+  printf("  \"input\": {\n");
+  printf("    \"M\": %d,\n", g->M);
+  printf("    \"N\": %d,\n", g->N);
+  printf("    \"K\": %d,\n", g->K);
+  printf("    \"repeats\": %d,\n", repeats);
+  printf("    \"precision\": \"%s\",\n", precision_name(g->prec));
+  printf("    \"cold_samples\": %d\n", requested);
+  printf("  },\n");
+  if (error || n == 0) {
+    printf("  \"error\": \"%s\"\n", error ? error : "no cold-start sample succeeded");
+    printf("}");
+    return;
+  }
+  // Per phase over the processes: min/median/max seconds and the median page faults
+  double* secs = (double*)malloc((size_t)n * sizeof(double));
+  double* faults = (double*)malloc((size_t)n * sizeof(double));
+  printf("  \"output\": {\n");
+  printf("    \"cold_start\": {\n");
+  printf("      \"samples\": %d", n);
+  for (int p = 0; secs && faults && p < COLD_PHASES; ++p) {
+    int m = 0;
+    for (int i = 0; i < n; ++i) {
+      if (tl[i].secs[p] < 0.0) continue;
+      secs[m] = tl[i].secs[p];
+      faults[m++] = (double)tl[i].faults[p];
+    }
+    if (m == 0) continue;
+    TimingStats st, fault_st;
+    if (timing_stats(secs, m, 0, &st) != 0 || timing_stats(faults, m, 0, &fault_st) != 0) continue;
+    double max = secs[0];
+    for (int i = 1; i < m; ++i) if (secs[i] > max) max = secs[i];
+    printf(",\n      \"%s\": {\"min_sec\": %.6f, \"median_sec\": %.6f, \"max_sec\": %.6f",
+           cold_phase_names[p], st.min, st.median, max);
+    if (p != COLD_EXEC_TO_MAIN && p != COLD_FIRST_RESULT) printf(", \"page_faults\": %.0f", fault_st.median);
+    printf("}");
+  }
+  printf("\n    }\n");
+  printf("  }\n");
+  printf("}");
+  free(secs);
+  free(faults);
+}
+
+// --cold-start: one timeline of this process. --cold-samples=S: S fresh processes, summarised.
+// A child started by cold_start_children() hands its timeline back instead of printing it.
+static int run_cold_start(int argc, char** argv, const char* plugin, const char* bind, BlasGemmArgs* g,
+                          const MatrixAllocOptions* aopt, int repeats, int samples, double main_sec) {
+  const char* fd = getenv("BLAS_COLD_FD");
+  if (samples == 0 && fd) {
+    ColdTimeline tl;
+    cold_start_once(plugin, g, aopt, repeats, main_sec, &tl);
+    const ssize_t written = write(atoi(fd), &tl, sizeof tl);
+    return written == (ssize_t)sizeof tl && !tl.failed ? 0 : 3;
+  }
+  ColdTimeline* tl = (ColdTimeline*)calloc((size_t)(samples > 0 ? samples : 1), sizeof(ColdTimeline));
+  if (!tl) return 1;
+  int n;
+  if (samples > 0) {
+    n = cold_start_children(argv, argc, tl, samples);
+  } else {
+    cold_start_once(plugin, g, aopt, repeats, main_sec, tl);
+    n = tl->failed ? 0 : 1;
+  }
+  // The parent loads the backend only now, for its engine JSON
+  const BlasBackend* be = plugin ? load_plugin(plugin) : &blas_backend;
+  char eng[768];
+  engine_info(be, plugin, bind, eng, sizeof eng);
+  print_cold_results(eng, g, repeats, tl, n, samples > 0 ? samples : 1, be ? NULL : "plugin could not be loaded");
+  printf("\n");
+  free(tl);
+  return n > 0 && be ? 0 : 3;
+}
+
+int main(int argc, char** argv) {
+  const double main_sec = now_sec();
+  int pos[3] = { 2048, 2048, 50 };
+  int npos = 0;
+  int thread_sweep = 0;
+  int shape_sweep = 0;
+  int (*custom_shapes)[3] = NULL;
+  int ncustom = 0;
+  BlasGemmArgs g = { BLAS_PREC_S, BLAS_OP_N, BLAS_OP_N, 0, 0, 0, 0, 0, 0, { 1.0, 0.0 }, { 0.0, 0.0 } };
+  TimingOptions topt = { 1, 0.0, 10000, NULL, NULL };
+  MatrixAllocOptions aopt = { MATRIX_PAGES_DEFAULT, MATRIX_NUMA_NONE, 0, 0 };
+  int use_counters = 0;
+  int batch = 0;
+  VectorOptions vo;
+  memset(&vo, 0, sizeof vo);
+  int vector_mode = 0;
+  vo.stream_threads = stream_default_threads();
+  const char* plugins[MAX_PLUGINS];
+  int nplugins = 0;
+  AffinityPolicy binds[AFFINITY_MAX_POLICIES];
+  int nbinds = 0;
+  int ntenants = 0;
+  int tenant_threads = 0;
+  int cold_start = 0;
+  int cold_samples = 0;
+  for (int i = 1; i < argc; ++i) {
+    const char* v;
+    int ok = 1;
+    if (strcmp(argv[i], "--thread-sweep") == 0) thread_sweep = 1;
+    else if (strcmp(argv[i], "--sweep") == 0) shape_sweep = 1;
+    else if (strcmp(argv[i], "--counters") == 0) use_counters = 1;
+    else if (strcmp(argv[i], "--cold-start") == 0) cold_start = 1;
+    else if ((v = opt_value(argv[i], "cold-samples"))) ok = (cold_samples = atoi(v)) > 0;
+    else if ((v = opt_value(argv[i], "shapes"))) { shape_sweep = 1; free(custom_shapes); ok = (ncustom = parse_shapes(v, &custom_shapes)) > 0; }
+    else if ((v = opt_value(argv[i], "level"))) ok = vector_mode = parse_level(v, vo.ops);
+    else if ((v = opt_value(argv[i], "vector-ops"))) ok = vector_mode = parse_vector_ops(v, vo.ops);
+    else if ((v = opt_value(argv[i], "working-sets"))) { free(vo.sets); ok = (vo.nsets = parse_sizes(v, &vo.sets)) > 0; }
+    else if ((v = opt_value(argv[i], "stream-threads"))) ok = (vo.stream_threads = atoi(v)) > 0;
+    else if ((v = opt_value(argv[i], "tenants"))) ok = (ntenants = atoi(v)) > 0 && ntenants <= MAX_TENANTS;
+    else if ((v = opt_value(argv[i], "tenant-threads"))) ok = (tenant_threads = atoi(v)) > 0;
+    else if ((v = opt_value(argv[i], "bind"))) ok = (nbinds = affinity_parse_policies(v, binds, AFFINITY_MAX_POLICIES)) > 0;
+    else if ((v = opt_value(argv[i], "plugin"))) { ok = nplugins < MAX_PLUGINS; if (ok) plugins[nplugins++] = v; }
+    else if ((v = opt_value(argv[i], "pages"))) ok = matrix_parse_pages(v, &aopt.pages);
+    else if ((v = opt_value(argv[i], "numa"))) ok = matrix_parse_numa(v, &aopt.numa, &aopt.node);
+    else if ((v = opt_value(argv[i], "first-touch"))) ok = (aopt.parallel_touch = strcmp(v, "parallel") == 0) || strcmp(v, "serial") == 0;
+    else if ((v = opt_value(argv[i], "batch"))) ok = (batch = atoi(v)) > 0;
+    else if ((v = opt_value(argv[i], "warmup"))) ok = (topt.warmup = atoi(v)) >= 0;
+    else if ((v = opt_value(argv[i], "target-ci"))) ok = (topt.target_ci = atof(v)) > 0.0;
+    else if ((v = opt_value(argv[i], "max-repeats"))) ok = (topt.max_repeats = atoi(v)) > 0;
+    else if ((v = opt_value(argv[i], "precision"))) ok = parse_precision(v, &g.prec);
+    else if ((v = opt_value(argv[i], "transa"))) ok = parse_transpose(v, &g.transA);
+    else if ((v = opt_value(argv[i], "transb"))) ok = parse_transpose(v, &g.transB);
+    else if ((v = opt_value(argv[i], "alpha"))) ok = parse_scalar(v, g.alpha);
+    else if ((v = opt_value(argv[i], "beta"))) ok = parse_scalar(v, g.beta);
+    else if ((v = opt_value(argv[i], "lda"))) ok = (g.lda = atoi(v)) > 0;
+    else if ((v = opt_value(argv[i], "ldb"))) ok = (g.ldb = atoi(v)) > 0;
+    else if ((v = opt_value(argv[i], "ldc"))) ok = (g.ldc = atoi(v)) > 0;
+    else if (argv[i][0] == '-' && argv[i][1] == '-') ok = 0;
+    else if (npos < 3) pos[npos++] = atoi(argv[i]);
+    if (!ok) {
+      fprintf(stderr, "Invalid option: %s\n", argv[i]);
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  int N = pos[0];
+  int K = pos[1];
+  int repeats = pos[2];
+
+  if (N <= 0 || K <= 0 || repeats <= 0 || (shape_sweep && thread_sweep) ||
+      (vector_mode && (shape_sweep || thread_sweep || batch > 0 || (g.prec != BLAS_PREC_S && g.prec != BLAS_PREC_D))) ||
+      (ntenants > 0 && (shape_sweep || vector_mode || thread_sweep || batch > 0 || topt.target_ci > 0.0)) ||
+      ((cold_start || cold_samples > 0) && (shape_sweep || vector_mode || thread_sweep || batch > 0 || ntenants > 0 ||
+                                            nplugins > 1 || repeats < 3))) {
+    usage(argv[0]);
+    return 1;
+  }
+  // Several policies: one child process per policy. One policy: the OpenMP runtimes read
+  // OMP_PROC_BIND/OMP_PLACES when they are loaded, so set them up and start over.
+  if (nbinds > 1) return run_bind_sweep(argc, argv, binds, nbinds);
+  if (nbinds == 1 && !affinity_env_applied(binds[0])) {
+    if (affinity_apply_env(binds[0]) != 0) {
+      fprintf(stderr, "Cannot set up --bind=%s\n", affinity_policy_name(binds[0]));
+      return 1;
+    }
+    execv("/proc/self/exe", argv);
+    fprintf(stderr, "Re-executing for --bind failed; libraries loaded at startup keep their binding\n");
+  }
+  if (cold_start || cold_samples > 0) {
+    g.M = N; g.N = N; g.K = K;
+    return run_cold_start(argc, argv, nplugins > 0 ? plugins[0] : NULL, nbinds == 1 ? affinity_policy_name(binds[0]) : NULL,
+                          &g, &aopt, repeats, cold_samples, main_sec);
+  }
+  if (vector_mode && ((vo.nsets == 0 && (vo.nsets = default_working_sets(&vo.sets)) == 0) ||
+                      measure_stream_baselines(&vo) != 0)) {
+    fprintf(stderr, "STREAM baseline failed\n");
+    return 1;
+  }
+
+  // Before loading plugins and blas_init(), so the backends' worker threads inherit the counters
+  PerfCounters counters;
+  if (use_counters) {
+    perf_counters_open(&counters);
+    topt.counters = &counters;
+  }
+
+  // Around the same timed calls; left out of the results if no RAPL zone is readable
+  EnergyCounters energy;
+  if (energy_open(&energy) > 0) topt.energy = &energy;
+
+  // Built-in backend, or the plugins back to back
+  const BlasBackend* backends[MAX_PLUGINS] = { &blas_backend };
+  const int nbackends = nplugins > 0 ? nplugins : 1;
+  for (int i = 0; i < nplugins; ++i) backends[i] = load_plugin(plugins[i]);
+
+  const int M = N; // square by default
+  g.M = M; g.N = N; g.K = K;
+  Operands op;
+  memset(&op, 0, sizeof op);
+  if (!shape_sweep && !vector_mode && ntenants == 0 && setup_operands(&g, &op, &aopt, batch) != 0) return 1;
+  if (ntenants > 0 && tenant_threads == 0) {
+    tenant_threads = stream_default_threads() / ntenants;
+    if (tenant_threads < 1) tenant_threads = 1;
+  }
+
+  // A single run prints one object; sweeps and plugins print one array with every result
+  const int as_array = shape_sweep || vector_mode || nplugins > 0;
+  int nitems = 0;
+  int rc = 0;
+  if (as_array) printf("[\n");
+  for (int b = 0; b < nbackends; ++b) {
+    char eng[768];
+    engine_info(backends[b], nplugins > 0 ? plugins[b] : NULL, nbinds == 1 ? affinity_policy_name(binds[0]) : NULL, eng, sizeof eng);
+    int r;
+    if (!backends[b]) {
+      json_array_sep(&nitems);
+      print_json_results(eng, &g, shape_sweep || vector_mode || ntenants > 0 ? NULL : &op, repeats, "plugin could not be loaded", -1.0, 0.0f, NULL, NULL, NULL, NULL, 0);
+      r = 4;
+    } else if (ntenants > 0) {
+      if (as_array) json_array_sep(&nitems);
+      r = run_multi_tenant(backends[b], eng, &g, &aopt, ntenants, tenant_threads, repeats, topt.warmup);
+    } else if (vector_mode) {
+      r = run_vector_sweep(backends[b], eng, g.prec, &vo, repeats, &topt, &aopt, &nitems);
+    } else if (shape_sweep) {
+      r = custom_shapes
+        ? run_shape_sweep(backends[b], eng, &g, (const int (*)[3])custom_shapes, ncustom, N, K, repeats, batch, &topt, &aopt, &nitems)
+        : run_shape_sweep(backends[b], eng, &g, default_sweep_shapes,
+                          (int)(sizeof default_sweep_shapes / sizeof default_sweep_shapes[0]), N, K, repeats, batch, &topt, &aopt, &nitems);
+    } else {
+      if (as_array) json_array_sep(&nitems);
+      r = run_single(backends[b], eng, &g, &op, repeats, &topt, thread_sweep);
+    }
+    if (rc == 0) rc = r;
+    fflush(stdout);
+  }
+  printf(as_array ? "\n]\n" : "\n");
+
+  free(custom_shapes);
+  free(vo.sets);
+  free(vo.stream);
+  free_operands(&op);
+  if (use_counters) perf_counters_close(&counters);
+  return rc;
+}
@@ -0,0 +1,294 @@
+#define _GNU_SOURCE 1
+
+#include "matrix_alloc.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#define HUGE_PAGE_SIZE (2u << 20)
+
+#ifndef MAP_HUGE_SHIFT
+#  define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#  define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+
+// From <numaif.h>; called through syscall() so libnuma isn't needed
+#define MPOL_BIND_ 2
+#define MPOL_INTERLEAVE_ 3
+
+// Live allocations (3 matrices per tenant with --tenants), grown on demand
+typedef struct Allocation {
+  void* ptr;        // as returned to the caller
+  void* base;       // mapping (mmap) or posix_memalign block
+  size_t len;       // mapping length, 0 for posix_memalign
+  MatrixPages pages;
+} Allocation;
+
+static Allocation* allocs;
+static size_t allocs_cap;
+static pthread_mutex_t allocs_mu = PTHREAD_MUTEX_INITIALIZER;
+
+// Returns 0 if the table can't grow; the caller must then release the memory itself
+static int remember(void* ptr, void* base, size_t len, MatrixPages pages) {
+  pthread_mutex_lock(&allocs_mu);
+  size_t slot = allocs_cap;
+  for (size_t i = 0; i < allocs_cap; ++i) {
+    if (allocs[i].ptr == NULL) { slot = i; break; }
+  }
+  int ok = slot < allocs_cap;
+  if (!ok) {
+    const size_t cap = allocs_cap ? 2 * allocs_cap : 32;
+    Allocation* grown = (Allocation*)realloc(allocs, cap * sizeof(Allocation));
+    if (grown) {
+      memset(grown + allocs_cap, 0, (cap - allocs_cap) * sizeof(Allocation));
+      ok = 1;
+      allocs = grown;
+      allocs_cap = cap;
+    }
+  }
+  if (ok) {
+    allocs[slot].ptr = ptr; allocs[slot].base = base; allocs[slot].len = len; allocs[slot].pages = pages;
+  }
+  pthread_mutex_unlock(&allocs_mu);
+  return ok;
+}
+
+static Allocation* lookup(const void* ptr) {
+  for (size_t i = 0; i < allocs_cap; ++i) {
+    if (allocs[i].ptr == ptr) return &allocs[i];
+  }
+  return NULL;
+}
+
+// Maps `len` bytes (a multiple of 2 MiB) at a 2 MiB boundary, so THP can back all of it
+static void* map_aligned(size_t len, void** base, size_t* mapped) {
+  size_t over = len + HUGE_PAGE_SIZE;
+  char* p = (char*)mmap(NULL, over, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) return NULL;
+  char* aligned = (char*)(((uintptr_t)p + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1));
+  if (aligned > p) munmap(p, (size_t)(aligned - p));
+  size_t tail = (size_t)(p + over - (aligned + len));
+  if (tail > 0) munmap(aligned + len, tail);
+  *base = aligned;
+  *mapped = len;
+  return aligned;
+}
+
+// Online NUMA nodes as a bitmask (node 0 only if unknown)
+static unsigned long online_nodes(void) {
+  unsigned long mask = 0;
+  FILE* f = fopen("/sys/devices/system/node/online", "r");
+  char line[256];
+  if (f && fgets(line, sizeof line, f)) {
+    for (char* s = line; *s && *s != '\n';) {
+      char* end;
+      long a = strtol(s, &end, 10), b = a;
+      if (end == s) break;
+      if (*end == '-') b = strtol(end + 1, &end, 10);
+      for (long n = a; n <= b && n < (long)(8 * sizeof mask); ++n) mask |= 1ul << n;
+      s = *end == ',' ? end + 1 : end;
+    }
+  }
+  if (f) fclose(f);
+  return mask ? mask : 1ul;
+}
+
+static int apply_numa(void* p, size_t len, const MatrixAllocOptions* opt) {
+  unsigned long mask;
+  int mode;
+  if (opt->numa == MATRIX_NUMA_INTERLEAVE) {
+    mode = MPOL_INTERLEAVE_;
+    mask = online_nodes();
+  } else {
+    mode = MPOL_BIND_;
+    mask = 1ul << opt->node;
+  }
+  if (syscall(SYS_mbind, p, len, mode, &mask, 8 * sizeof mask + 1, 0) != 0) {
+    perror("mbind");
+    return 1;
+  }
+  return 0;
+}
+
+static void touch_range(char* p, size_t len) {
+  const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  for (size_t off = 0; off < len; off += page) p[off] = 0;
+}
+
+typedef struct TouchJob {
+  char* p;
+  size_t len;
+  int cpu;
+  pthread_t thread;
+} TouchJob;
+
+static void* touch_main(void* arg) {
+  TouchJob* job = (TouchJob*)arg;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(job->cpu, &set);
+  pthread_setaffinity_np(pthread_self(), sizeof set, &set);
+  touch_range(job->p, job->len);
+  return NULL;
+}
+
+// First touch from one thread per allowed CPU, each on a contiguous slice (huge page granular),
+// so that without mbind the pages end up spread over the nodes the benchmark runs on
+static void parallel_touch(char* p, size_t len) {
+  cpu_set_t allowed;
+  int n = 0;
+  // Per call: tenants allocate their matrices concurrently
+  int* cpus = sched_getaffinity(0, sizeof allowed, &allowed) == 0 && CPU_COUNT(&allowed) > 0
+            ? (int*)calloc((size_t)CPU_COUNT(&allowed), sizeof(int)) : NULL;
+  if (cpus) {
+    for (int c = 0; c < CPU_SETSIZE; ++c) if (CPU_ISSET(c, &allowed)) cpus[n++] = c;
+  }
+  const size_t chunks = (len + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE;
+  if (n > (int)chunks) n = (int)chunks;
+  TouchJob* jobs = n > 1 ? (TouchJob*)calloc((size_t)n, sizeof(TouchJob)) : NULL;
+  if (!jobs) {
+    free(cpus);
+    touch_range(p, len);
+    return;
+  }
+
+  int* started = (int*)calloc((size_t)n, sizeof(int));
+  for (int t = 0; t < n; ++t) {
+    const size_t off0 = chunks * t / n * HUGE_PAGE_SIZE, off1 = chunks * (t + 1) / n * HUGE_PAGE_SIZE;
+    jobs[t].p = p + off0;
+    jobs[t].len = (off1 < len ? off1 : len) - off0;
+    jobs[t].cpu = cpus[t];
+    if (started && pthread_create(&jobs[t].thread, NULL, touch_main, &jobs[t]) == 0) started[t] = 1;
+    else touch_range(jobs[t].p, jobs[t].len);
+  }
+  for (int t = 0; t < n; ++t) {
+    if (started && started[t]) pthread_join(jobs[t].thread, NULL);
+  }
+  free(started);
+  free(jobs);
+  free(cpus);
+}
+
+void* matrix_alloc(size_t bytes, const MatrixAllocOptions* opt) {
+  if (bytes == 0) bytes = 1;
+  if (opt->pages == MATRIX_PAGES_DEFAULT && opt->numa == MATRIX_NUMA_NONE && !opt->parallel_touch) {
+    void* p = NULL;
+    if (posix_memalign(&p, 64, bytes) != 0) return NULL;
+    if (!remember(p, p, 0, MATRIX_PAGES_DEFAULT)) {
+      free(p);
+      return NULL;
+    }
+    return p;
+  }
+
+  const size_t len = (bytes + HUGE_PAGE_SIZE - 1) & ~(size_t)(HUGE_PAGE_SIZE - 1);
+  MatrixPages pages = opt->pages;
+  void* base = NULL;
+  size_t mapped = 0;
+  void* p = NULL;
+  if (pages == MATRIX_PAGES_HUGETLB) {
+    p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_HUGE_2MB, -1, 0);
+    if (p == MAP_FAILED) {
+      p = NULL;
+      pages = MATRIX_PAGES_THP; // no (free) 2 MiB pages in the hugetlb pool
+    } else {
+      base = p;
+      mapped = len;
+    }
+  }
+  if (!p) {
+    p = map_aligned(len, &base, &mapped);
+    if (!p) return NULL;
+    if (pages == MATRIX_PAGES_THP) madvise(p, len, MADV_HUGEPAGE);
+  }
+
+  if (opt->numa != MATRIX_NUMA_NONE && apply_numa(p, len, opt) != 0) {
+    munmap(base, mapped);
+    return NULL;
+  }
+  if (opt->parallel_touch) parallel_touch((char*)p, bytes);
+
+  if (!remember(p, base, mapped, pages)) {
+    munmap(base, mapped);
+    return NULL;
+  }
+  return p;
+}
+
+void matrix_free(void* p) {
+  if (!p) return;
+  pthread_mutex_lock(&allocs_mu);
+  Allocation* a = lookup(p);
+  Allocation copy = { NULL, NULL, 0, MATRIX_PAGES_DEFAULT };
+  if (a) { copy = *a; a->ptr = NULL; }
+  pthread_mutex_unlock(&allocs_mu);
+
+  if (!copy.ptr) fprintf(stderr, "matrix_free: %p was not allocated by matrix_alloc, not freed\n", p);
+  else if (copy.len == 0) free(copy.base);
+  else munmap(copy.base, copy.len);
+}
+
+MatrixPages matrix_pages_of(const void* p) {
+  pthread_mutex_lock(&allocs_mu);
+  const Allocation* a = lookup(p);
+  MatrixPages pages = a ? a->pages : MATRIX_PAGES_DEFAULT;
+  pthread_mutex_unlock(&allocs_mu);
+  return pages;
+}
+
+size_t matrix_huge_bytes(const void* p, size_t bytes) {
+  FILE* f = fopen("/proc/self/smaps", "r");
+  if (!f) return 0;
+  const uintptr_t lo = (uintptr_t)p, hi = lo + bytes;
+  char line[256];
+  int inside = 0;
+  size_t kb = 0;
+  while (fgets(line, sizeof line, f)) {
+    unsigned long start, end;
+    size_t v;
+    if (sscanf(line, "%lx-%lx ", &start, &end) == 2) { // mapping header, followed by its fields
+      inside = start < hi && end > lo;
+    } else if (inside && (sscanf(line, "AnonHugePages: %zu kB", &v) == 1 ||
+                          sscanf(line, "Private_Hugetlb: %zu kB", &v) == 1 ||
+                          sscanf(line, "Shared_Hugetlb: %zu kB", &v) == 1)) {
+      kb += v;
+    }
+  }
+  fclose(f);
+  // A VMA can extend beyond the matrix (merged with a neighbouring mapping)
+  return kb * 1024 < bytes ? kb * 1024 : bytes;
+}
+
+const char* matrix_pages_name(MatrixPages pages) {
+  static const char* names[] = { "default", "thp", "hugetlb" };
+  return names[pages];
+}
+
+int matrix_parse_pages(const char* s, MatrixPages* pages) {
+  if (strcmp(s, "default") == 0) *pages = MATRIX_PAGES_DEFAULT;
+  else if (strcmp(s, "thp") == 0) *pages = MATRIX_PAGES_THP;
+  else if (strcmp(s, "hugetlb") == 0) *pages = MATRIX_PAGES_HUGETLB;
+  else return 0;
+  return 1;
+}
+
+int matrix_parse_numa(const char* s, MatrixNuma* numa, int* node) {
+  char* end;
+  if (strcmp(s, "none") == 0) *numa = MATRIX_NUMA_NONE;
+  else if (strcmp(s, "interleave") == 0) *numa = MATRIX_NUMA_INTERLEAVE;
+  else {
+    long n = strtol(s, &end, 10);
+    if (end == s || *end != '\0' || n < 0 || n >= (long)(8 * sizeof(unsigned long))) return 0;
+    *numa = MATRIX_NUMA_BIND;
+    *node = (int)n;
+  }
+  return 1;
+}
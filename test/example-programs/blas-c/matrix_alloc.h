@@ -0,0 +1,49 @@
+#pragma once
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Allocation of the benchmark matrices: page size, NUMA placement and who touches the pages first.
+
+typedef enum MatrixPages {
+  MATRIX_PAGES_DEFAULT = 0, // posix_memalign (4 KiB pages unless THP is "always")
+  MATRIX_PAGES_THP,         // 2 MiB aligned mmap + madvise(MADV_HUGEPAGE)
+  MATRIX_PAGES_HUGETLB      // mmap(MAP_HUGETLB) from the 2 MiB pool; falls back to THP if the pool is empty
+} MatrixPages;
+
+typedef enum MatrixNuma {
+  MATRIX_NUMA_NONE = 0,     // kernel default: on the node of the first touching thread
+  MATRIX_NUMA_INTERLEAVE,   // mbind(MPOL_INTERLEAVE) over all online nodes
+  MATRIX_NUMA_BIND          // mbind(MPOL_BIND) to `node`
+} MatrixNuma;
+
+typedef struct MatrixAllocOptions {
+  MatrixPages pages;
+  MatrixNuma numa;
+  int node;                 // for MATRIX_NUMA_BIND
+  int parallel_touch;       // touch the pages from one pinned thread per CPU before returning
+} MatrixAllocOptions;
+
+// Allocates `bytes` aligned to at least 64 bytes according to `opt`; NULL on failure.
+void* matrix_alloc(size_t bytes, const MatrixAllocOptions* opt);
+
+// Frees memory from matrix_alloc(); NULL is ignored.
+void matrix_free(void* p);
+
+// Page kind actually used for `p` (differs from the request after a hugetlb fallback).
+MatrixPages matrix_pages_of(const void* p);
+
+// Bytes of [p, p + bytes) currently backed by huge pages (from /proc/self/smaps), 0 if unknown.
+size_t matrix_huge_bytes(const void* p, size_t bytes);
+
+const char* matrix_pages_name(MatrixPages pages);
+
+// Parse "default|thp|hugetlb" and "none|interleave|<node>"; return 0 on invalid input.
+int matrix_parse_pages(const char* s, MatrixPages* pages);
+int matrix_parse_numa(const char* s, MatrixNuma* numa, int* node);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,192 @@
+#define _GNU_SOURCE 1
+
+#include "matrix_fill.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define LCG_A 1664525u
+#define LCG_C 1013904223u
+#define LANES 16                        // independent LCG streams per loop iteration (SIMD width)
+#define FILL_CHUNK ((size_t)1 << 20)    // scalars per thread task
+#define SUM_BLOCK ((size_t)1 << 16)     // scalars per checksum block (fixed: keeps the result thread-independent)
+
+// --- Tiny fork/join helper: runs fn(ctx, task) for task in [0, ntasks) on up to one thread per CPU ---
+
+typedef void (*task_fn)(void* ctx, size_t task);
+
+typedef struct ParallelJob {
+  task_fn fn;
+  void* ctx;
+  size_t ntasks;
+  int nthreads;
+  int id;
+} ParallelJob;
+
+static void* parallel_main(void* arg) {
+  const ParallelJob* job = (const ParallelJob*)arg;
+  const size_t t0 = job->ntasks * job->id / job->nthreads;
+  const size_t t1 = job->ntasks * (job->id + 1) / job->nthreads;
+  for (size_t t = t0; t < t1; ++t) job->fn(job->ctx, t);
+  return NULL;
+}
+
+static void parallel_for(size_t ntasks, task_fn fn, void* ctx) {
+  cpu_set_t allowed;
+  int nthreads = sched_getaffinity(0, sizeof allowed, &allowed) == 0 ? CPU_COUNT(&allowed) : 1;
+  if (nthreads > 256) nthreads = 256;
+  if ((size_t)nthreads > ntasks) nthreads = (int)ntasks;
+  if (nthreads <= 1) {
+    for (size_t t = 0; t < ntasks; ++t) fn(ctx, t);
+    return;
+  }
+
+  pthread_t threads[256];
+  ParallelJob jobs[256];
+  int started[256] = { 0 };
+  for (int i = 0; i < nthreads; ++i) {
+    jobs[i].fn = fn; jobs[i].ctx = ctx; jobs[i].ntasks = ntasks; jobs[i].nthreads = nthreads; jobs[i].id = i;
+    // Thread 0's share runs on the calling thread, as does any share whose thread can't start
+    started[i] = i > 0 && pthread_create(&threads[i], NULL, parallel_main, &jobs[i]) == 0;
+  }
+  for (int i = 0; i < nthreads; ++i) {
+    if (!started[i]) parallel_main(&jobs[i]);
+  }
+  for (int i = 1; i < nthreads; ++i) {
+    if (started[i]) pthread_join(threads[i], NULL);
+  }
+}
+
+// --- LCG with jump-ahead ---
+
+// Affine map x -> a*x + c (mod 2^32); k steps of the LCG are again such a map
+typedef struct LcgStep {
+  uint32_t a, c;
+} LcgStep;
+
+static LcgStep lcg_jump(uint64_t k) {
+  LcgStep r = { 1u, 0u }, base = { LCG_A, LCG_C };
+  while (k) {
+    if (k & 1) { r.c = base.a * r.c + base.c; r.a *= base.a; }
+    base.c = base.a * base.c + base.c;
+    base.a *= base.a;
+    k >>= 1;
+  }
+  return r;
+}
+
+typedef struct FillJob {
+  void* M;
+  int is_double;
+  size_t scalars;
+  uint32_t seed;
+} FillJob;
+
+static void fill_task(void* ctx, size_t task) {
+  const FillJob* job = (const FillJob*)ctx;
+  const size_t i0 = task * FILL_CHUNK;
+  const size_t i1 = i0 + FILL_CHUNK < job->scalars ? i0 + FILL_CHUNK : job->scalars;
+
+  // Element i uses the state after i + 1 steps; lane l starts at element i0 + l
+  uint32_t x[LANES];
+  const LcgStep first = lcg_jump(i0 + 1);
+  x[0] = first.a * job->seed + first.c;
+  for (int l = 1; l < LANES; ++l) x[l] = LCG_A * x[l - 1] + LCG_C;
+  const LcgStep stride = lcg_jump(LANES);
+
+  size_t i = i0;
+  if (job->is_double) {
+    double* out = (double*)job->M;
+    for (; i + LANES <= i1; i += LANES) {
+      for (int l = 0; l < LANES; ++l) {
+        out[i + l] = (float)((x[l] >> 8) & 0xFFFF) / 32768.0f - 1.0f;
+        x[l] = stride.a * x[l] + stride.c;
+      }
+    }
+    for (int l = 0; i < i1; ++i, ++l) out[i] = (float)((x[l] >> 8) & 0xFFFF) / 32768.0f - 1.0f;
+  } else {
+    float* out = (float*)job->M;
+    for (; i + LANES <= i1; i += LANES) {
+      for (int l = 0; l < LANES; ++l) {
+        out[i + l] = (float)((x[l] >> 8) & 0xFFFF) / 32768.0f - 1.0f;
+        x[l] = stride.a * x[l] + stride.c;
+      }
+    }
+    for (int l = 0; i < i1; ++i, ++l) out[i] = (float)((x[l] >> 8) & 0xFFFF) / 32768.0f - 1.0f;
+  }
+}
+
+void matrix_fill_lcg(void* M, int is_double, size_t scalars, unsigned seed) {
+  FillJob job = { M, is_double, scalars, seed ? seed : 1u };
+  parallel_for((scalars + FILL_CHUNK - 1) / FILL_CHUNK, fill_task, &job);
+}
+
+// --- Checksum ---
+
+// Pairwise summation: error grows with log(n) instead of n, and there is no compensation
+// term that -ffast-math could optimize away (unlike Kahan)
+static double pairwise_f(const float* x, size_t n) {
+  if (n <= 128) {
+    double s = 0.0;
+    for (size_t i = 0; i < n; ++i) s += x[i];
+    return s;
+  }
+  const size_t h = n / 2;
+  return pairwise_f(x, h) + pairwise_f(x + h, n - h);
+}
+
+static double pairwise_d(const double* x, size_t n) {
+  if (n <= 128) {
+    double s = 0.0;
+    for (size_t i = 0; i < n; ++i) s += x[i];
+    return s;
+  }
+  const size_t h = n / 2;
+  return pairwise_d(x, h) + pairwise_d(x + h, n - h);
+}
+
+typedef struct SumJob {
+  const void* M;
+  int is_double;
+  size_t row_scalars, ld_scalars;
+  size_t rows, rows_per_block;
+  double* partial;   // one per block
+} SumJob;
+
+static double block_sum(const SumJob* job, size_t block) {
+  const size_t r0 = block * job->rows_per_block;
+  const size_t r1 = r0 + job->rows_per_block < job->rows ? r0 + job->rows_per_block : job->rows;
+  double s = 0.0;
+  for (size_t r = r0; r < r1; ++r) {
+    // Long rows are split into SUM_BLOCK pieces as well, so each piece is summed the same way
+    for (size_t j = 0; j < job->row_scalars; j += SUM_BLOCK) {
+      const size_t n = job->row_scalars - j < SUM_BLOCK ? job->row_scalars - j : SUM_BLOCK;
+      s += job->is_double ? pairwise_d((const double*)job->M + r * job->ld_scalars + j, n)
+                          : pairwise_f((const float*)job->M + r * job->ld_scalars + j, n);
+    }
+  }
+  return s;
+}
+
+static void sum_task(void* ctx, size_t block) {
+  const SumJob* job = (const SumJob*)ctx;
+  job->partial[block] = block_sum(job, block);
+}
+
+double matrix_sum(const void* M, int is_double, int rows, size_t row_scalars, size_t ld_scalars) {
+  if (rows <= 0 || row_scalars == 0) return 0.0;
+  SumJob job = { M, is_double, row_scalars, ld_scalars, (size_t)rows, 0, NULL };
+  job.rows_per_block = row_scalars >= SUM_BLOCK ? 1 : SUM_BLOCK / row_scalars;
+  const size_t nblocks = (job.rows + job.rows_per_block - 1) / job.rows_per_block;
+  job.partial = (double*)malloc(nblocks * sizeof(double));
+  if (!job.partial) {
+    double s = 0.0;
+    for (size_t b = 0; b < nblocks; ++b) s += block_sum(&job, b);
+    return s;
+  }
+  parallel_for(nblocks, sum_task, &job);
+  const double s = pairwise_d(job.partial, nblocks);
+  free(job.partial);
+  return s;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Multi-threaded input generation and checksums for the benchmark matrices.
+// Both give the same results as the serial loops, independent of the number of threads.
+
+// Fills `scalars` floats (or doubles) with the harness' LCG sequence
+//   x' = 1664525 x + 1013904223 (mod 2^32), value = ((x >> 8) & 0xFFFF) / 32768 - 1
+// starting from `seed` (0 counts as 1). Threads and SIMD lanes jump ahead in the sequence.
+void matrix_fill_lcg(void* M, int is_double, size_t scalars, unsigned seed);
+
+// Sum of `row_scalars` floats (or doubles) of each of `rows` rows, `ld_scalars` apart.
+// Pairwise summation over fixed-size blocks, so the result doesn't depend on the thread count.
+double matrix_sum(const void* M, int is_double, int rows, size_t row_scalars, size_t ld_scalars);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,204 @@
+#define _GNU_SOURCE 1
+
+#include "perf_counters.h"
+#include <dirent.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#ifdef BLAS_HAVE_LIBPFM
+#  include <perfmon/pfmlib_perf_event.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#  include <cpuid.h>
+#endif
+
+// Thread ids of this process at open time
+static int tids[1024];
+static int ntids;
+
+static void collect_tids(void) {
+  ntids = 0;
+  DIR* d = opendir("/proc/self/task");
+  if (d) {
+    struct dirent* de;
+    while ((de = readdir(d)) != NULL && ntids < (int)(sizeof tids / sizeof tids[0])) {
+      if (de->d_name[0] != '.') tids[ntids++] = atoi(de->d_name);
+    }
+    closedir(d);
+  }
+  if (ntids == 0) tids[ntids++] = 0; // calling thread only
+}
+
+static void init_attr(struct perf_event_attr* attr) {
+  attr->size = sizeof(*attr);
+  attr->disabled = 1;
+  attr->inherit = 1;
+  attr->exclude_kernel = 1;
+  attr->exclude_hv = 1;
+  attr->read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+}
+
+// Opens `attr` on every thread (on any CPU); returns 0 if it could be opened at all, else errno
+static int open_event(PerfEvent* e, struct perf_event_attr* attr) {
+  init_attr(attr);
+  e->fds = (int*)malloc((size_t)ntids * sizeof(int));
+  e->nfds = 0;
+  int err = ENOMEM;
+  for (int i = 0; e->fds && i < ntids; ++i) {
+    int fd = (int)syscall(SYS_perf_event_open, attr, tids[i], -1, -1, 0);
+    if (fd >= 0) e->fds[e->nfds++] = fd;
+    else err = errno;  // also when a thread exited meanwhile
+  }
+  if (e->nfds == 0) {
+    free(e->fds);
+    e->fds = NULL;
+    return err;
+  }
+  return 0;
+}
+
+static int open_generic(PerfCounters* pc, const char* name, unsigned type, unsigned long long config) {
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof attr);
+  attr.type = type;
+  attr.config = config;
+  PerfEvent* e = &pc->events[pc->nevents++];
+  e->name = name;
+  return open_event(e, &attr);
+}
+
+#ifdef BLAS_HAVE_LIBPFM
+// Resolves a named event (e.g. "RETIRED_SSE_AVX_FLOPS:ANY") into `attr`; returns 0 on success
+static int pfm_encode(const char* event, struct perf_event_attr* attr) {
+  static int initialized = 0;
+  if (!initialized) initialized = pfm_initialize() == PFM_SUCCESS ? 1 : -1;
+  if (initialized < 0) return 1;
+
+  pfm_perf_encode_arg_t arg;
+  memset(&arg, 0, sizeof arg);
+  arg.attr = attr;
+  arg.size = sizeof arg;
+  return pfm_get_os_event_encoding(event, PFM_PLM3, PFM_OS_PERF_EVENT, &arg) != PFM_SUCCESS;
+}
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+static int is_amd_zen(void) {
+  unsigned eax, ebx, ecx, edx;
+  __builtin_cpu_init();
+  if (!__builtin_cpu_is("amd") || !__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return 0;
+  unsigned family = (eax >> 8) & 0xF;
+  if (family == 0xF) family += (eax >> 20) & 0xFF;
+  return family >= 0x17; // Zen 1/2 (0x17), Zen 3/4 (0x19), Zen 5 (0x1A)
+}
+#endif
+
+// FP ops retired has no generic perf event
+static void open_fp_ops(PerfCounters* pc) {
+  struct perf_event_attr attr;
+  PerfEvent* e = &pc->events[pc->nevents++];
+  e->name = "fp_ops";
+
+#ifdef BLAS_HAVE_LIBPFM
+  static const char* candidates[] = { "RETIRED_SSE_AVX_FLOPS:ANY", "RETIRED_SSE_AVX_FLOPS", NULL };
+  const char* forced = getenv("BLAS_PERF_FP_EVENT");
+  const char* single[] = { forced, NULL };
+  for (const char** name = forced ? single : candidates; *name && e->nfds == 0; ++name) {
+    memset(&attr, 0, sizeof attr);
+    if (pfm_encode(*name, &attr) != 0) continue;
+    if (open_event(e, &attr) == 0) snprintf(pc->fp_source, sizeof pc->fp_source, "libpfm:%s", *name);
+  }
+  if (e->nfds > 0 || forced) return;
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+  // PMCx003 "Retired SSE/AVX FLOPs", all unit masks (counts flops, an FMA counts two)
+  if (is_amd_zen()) {
+    memset(&attr, 0, sizeof attr);
+    attr.type = PERF_TYPE_RAW;
+    attr.config = 0xFF03;
+    if (open_event(e, &attr) == 0) snprintf(pc->fp_source, sizeof pc->fp_source, "raw:0xff03");
+  }
+#endif
+}
+
+static int read_paranoid(void) {
+  FILE* f = fopen("/proc/sys/kernel/perf_event_paranoid", "r");
+  int level = -99;
+  if (f) {
+    if (fscanf(f, "%d", &level) != 1) level = -99;
+    fclose(f);
+  }
+  return level;
+}
+
+void perf_counters_open(PerfCounters* pc) {
+  memset(pc, 0, sizeof *pc);
+  collect_tids();
+  int err = 0, e;
+
+  if ((e = open_generic(pc, "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES)) != 0) err = e;
+  if ((e = open_generic(pc, "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS)) != 0) err = e;
+  if ((e = open_generic(pc, "l1d_misses", PERF_TYPE_HW_CACHE,
+                        PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))) != 0) err = e;
+  if ((e = open_generic(pc, "llc_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES)) != 0) err = e;
+  open_fp_ops(pc);
+  if ((e = open_generic(pc, "branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES)) != 0) err = e;
+
+  for (int i = 0; i < pc->nevents; ++i) {
+    if (pc->events[i].nfds > 0) ++pc->nopen;
+  }
+  if (pc->nopen == 0) {
+    snprintf(pc->error, sizeof pc->error, "perf_event_open: %s (perf_event_paranoid=%d)",
+             strerror(err ? err : ENOENT), read_paranoid());
+  }
+}
+
+static void ioctl_all(PerfCounters* pc, unsigned long request) {
+  for (int i = 0; i < pc->nevents; ++i) {
+    for (int j = 0; j < pc->events[i].nfds; ++j) ioctl(pc->events[i].fds[j], request, 0);
+  }
+}
+
+void perf_counters_reset(PerfCounters* pc)   { ioctl_all(pc, PERF_EVENT_IOC_RESET); }
+void perf_counters_enable(PerfCounters* pc)  { ioctl_all(pc, PERF_EVENT_IOC_ENABLE); }
+void perf_counters_disable(PerfCounters* pc) { ioctl_all(pc, PERF_EVENT_IOC_DISABLE); }
+
+void perf_counters_read(PerfCounters* pc) {
+  for (int i = 0; i < pc->nevents; ++i) {
+    PerfEvent* e = &pc->events[i];
+    e->value = 0;
+    e->multiplexed = 0;
+    for (int j = 0; j < e->nfds; ++j) {
+      unsigned long long v[3]; // value, time enabled, time running (incl. inherited threads)
+      if (read(e->fds[j], v, sizeof v) != (ssize_t)sizeof v) continue;
+      if (v[2] < v[1]) e->multiplexed = 1;
+      e->value += v[2] > 0 && v[2] < v[1] ? (unsigned long long)((double)v[0] * v[1] / v[2]) : v[0];
+    }
+  }
+}
+
+void perf_counters_close(PerfCounters* pc) {
+  for (int i = 0; i < pc->nevents; ++i) {
+    for (int j = 0; j < pc->events[i].nfds; ++j) close(pc->events[i].fds[j]);
+    free(pc->events[i].fds);
+    pc->events[i].fds = NULL;
+    pc->events[i].nfds = 0;
+  }
+  pc->nopen = 0;
+}
+
+long long perf_counters_value(const PerfCounters* pc, const char* name) {
+  for (int i = 0; i < pc->nevents; ++i) {
+    if (pc->events[i].nfds > 0 && strcmp(pc->events[i].name, name) == 0) return (long long)pc->events[i].value;
+  }
+  return -1;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Hardware performance counters (Linux perf_event_open) around the timed GEMM region.
+// Only user-space events of this process's threads are counted (those existing at open time,
+// e.g. a BLAS library's pool started by a constructor, and all threads created later),
+// so this works with perf_event_paranoid <= 2.
+
+#define PERF_MAX_EVENTS 8
+
+typedef struct PerfEvent {
+  const char* name;          // JSON key, e.g. "cycles"
+  int* fds;                  // one per thread existing at open time
+  int nfds;                  // 0 if the event could not be opened
+  unsigned long long value;  // count between reset and the last read (scaled up if multiplexed)
+  int multiplexed;           // the event was not on a counter the whole time
+} PerfEvent;
+
+typedef struct PerfCounters {
+  PerfEvent events[PERF_MAX_EVENTS];
+  int nevents;
+  int nopen;                 // events with nfds > 0
+  char fp_source[96];        // where the "fp_ops" event came from, e.g. "libpfm:RETIRED_SSE_AVX_FLOPS:ANY"
+  char error[160];           // why no event could be opened (nopen == 0)
+} PerfCounters;
+
+// Opens cycles, instructions, L1D/LLC misses, FP ops retired and branch misses (all disabled).
+// Threads started later inherit the counters.
+// Events that can't be opened are skipped; `error` is set if none could be.
+// The FP event is resolved by libpfm when built with BLAS_HAVE_LIBPFM (BLAS_PERF_FP_EVENT overrides
+// the event name), otherwise a raw event is used on AMD Zen only.
+void perf_counters_open(PerfCounters* pc);
+
+void perf_counters_reset(PerfCounters* pc);
+void perf_counters_enable(PerfCounters* pc);
+void perf_counters_disable(PerfCounters* pc);
+
+// Reads the current values into events[].value.
+void perf_counters_read(PerfCounters* pc);
+
+void perf_counters_close(PerfCounters* pc);
+
+// Returns the value of the named event, or -1 if it is not available.
+long long perf_counters_value(const PerfCounters* pc, const char* name);
+
+#ifdef __cplusplus
+}
+#endif
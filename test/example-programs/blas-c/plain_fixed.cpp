@@ -0,0 +1,39 @@
+// Runtime lookup table over the compile-time kernels of plain_fixed.hpp.
+// Built with -fno-exceptions -fno-rtti; needs no C++ runtime, so C programs can link it with $CC.
+
+#include "plain_fixed.h"
+#include "plain_fixed.hpp"
+
+namespace {
+
+struct Entry {
+  int n;                 // M = N = K
+  plain_fixed_fn fn[4];  // indexed by transA * 2 + transB (0 = N, 1 = T)
+};
+
+template <int S>
+constexpr Entry entry() {
+  return { S, { plain_fixed::FixedSgemm<S, S, S, false, false>::run,
+                plain_fixed::FixedSgemm<S, S, S, false, true>::run,
+                plain_fixed::FixedSgemm<S, S, S, true, false>::run,
+                plain_fixed::FixedSgemm<S, S, S, true, true>::run } };
+}
+
+// Shapes of the small dense blocks in our workloads (3x3 rotations/stress tensors, 8..32 tiles)
+const Entry table[] = { entry<3>(), entry<4>(), entry<8>(), entry<16>(), entry<32>() };
+
+} // namespace
+
+extern "C" plain_fixed_fn plain_fixed_lookup(const BlasGemmArgs* g) {
+  if (g->prec != BLAS_PREC_S || g->M != g->N || g->N != g->K) return nullptr;
+  // BLAS_OP_C is BLAS_OP_T for real matrices
+  const int t = (g->transA != BLAS_OP_N) * 2 + (g->transB != BLAS_OP_N);
+  for (const Entry& e : table) {
+    if (e.n == g->M) return e.fn[t];
+  }
+  return nullptr;
+}
+
+extern "C" const char* plain_fixed_sizes_json(void) {
+  return "[3,4,8,16,32]";
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include "backend.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// SGEMM kernels specialised at compile time for a few square shapes (see plain_fixed.hpp).
+// C = alpha * op(A) * op(B) + beta * C, row-major, leading dimensions as in BlasGemmArgs.
+typedef void (*plain_fixed_fn)(const float* A, int lda, const float* B, int ldb,
+                               float* C, int ldc, float alpha, float beta);
+
+// Kernel for the precision, transposes and shape of `g`, or NULL (use the generic path).
+plain_fixed_fn plain_fixed_lookup(const BlasGemmArgs* g);
+
+// The sizes n with an n x n x n kernel, as a JSON array, e.g. "[3,4,8,16,32]"
+const char* plain_fixed_sizes_json(void);
+
+#ifdef __cplusplus
+}
+#endif
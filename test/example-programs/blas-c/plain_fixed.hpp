@@ -0,0 +1,117 @@
+#pragma once
+// Header-only SGEMM kernels for shapes fixed at compile time (C++17).
+//
+// FixedSgemm<M, N, K, TA, TB>::run() computes C = alpha * op(A) * op(B) + beta * C (row-major)
+// like sgemm_plain_block(), but every loop bound is a template parameter: the compiler fully
+// unrolls the register block, keeps the accumulators in vector registers and needs no edge
+// handling or bounds checks. TA/TB select op(A) = A^T / op(B) = B^T.
+//
+// Instantiate it for the shapes you need; plain_fixed.cpp builds the table the plain backend uses.
+
+namespace plain_fixed {
+
+// n itself if it fits in `limit`, else the largest of {limit, limit/2, ..., 1} dividing n,
+// so blocks tile the matrix exactly
+constexpr int block_size(int n, int limit) {
+  if (n <= limit) return n;
+  int b = limit;
+  while (n % b != 0) b /= 2;
+  return b;
+}
+
+// Floats per vector register of the target (-march decides)
+#if defined(__AVX512F__)
+constexpr int vector_floats = 16;
+#elif defined(__AVX__)
+constexpr int vector_floats = 8;
+#else
+constexpr int vector_floats = 4;
+#endif
+
+// W floats as one GCC/Clang vector
+template <int W> struct VecRow;
+template <> struct VecRow<4>  { typedef float type __attribute__((vector_size(16))); };
+template <> struct VecRow<8>  { typedef float type __attribute__((vector_size(32))); };
+template <> struct VecRow<16> { typedef float type __attribute__((vector_size(64))); };
+
+template <int M, int N, int K, bool TA, bool TB>
+struct FixedSgemm {
+  // Up to 8 rows x one vector register: 8 independent FMA chains hide the FMA latency;
+  // 3x3 and the like take the whole matrix
+  static constexpr int MR = block_size(M, 8);
+  static constexpr int NR = block_size(N, vector_floats);
+  static_assert(M % MR == 0 && N % NR == 0, "blocks must tile C");
+  static constexpr bool vector_path = NR == 4 || NR == 8 || NR == 16;
+
+  static inline float a_at(const float* __restrict A, int lda, int i, int k) {
+    return TA ? A[k * lda + i] : A[i * lda + k];
+  }
+  static inline float b_at(const float* __restrict B, int ldb, int k, int j) {
+    return TB ? B[j * ldb + k] : B[k * ldb + j];
+  }
+
+  static inline void store(const float (&acc)[MR][NR], float* __restrict C, int ldc,
+                           float alpha, float beta, int i0, int j0) {
+    for (int r = 0; r < MR; ++r) {
+      float* Cr = C + (i0 + r) * ldc + j0;
+      if (beta == 0.0f) for (int j = 0; j < NR; ++j) Cr[j] = alpha * acc[r][j];
+      else              for (int j = 0; j < NR; ++j) Cr[j] = alpha * acc[r][j] + beta * Cr[j];
+    }
+  }
+
+  // Scalar block: the compiler unrolls it completely (used for tiny or odd widths such as 3x3)
+  static void block_scalar(const float* __restrict A, int lda, const float* __restrict B, int ldb,
+                           float* __restrict C, int ldc, float alpha, float beta, int i0, int j0) {
+    float acc[MR][NR] = {};
+    for (int k = 0; k < K; ++k)
+      for (int r = 0; r < MR; ++r) {
+        const float a = a_at(A, lda, i0 + r, k);
+        for (int j = 0; j < NR; ++j) acc[r][j] += a * b_at(B, ldb, k, j0 + j);
+      }
+    store(acc, C, ldc, alpha, beta, i0, j0);
+  }
+
+  // Vector block: one NR-wide vector per row of the block, lowered to zmm/ymm/xmm as available.
+  // B is not transposed here (run() transposes it first).
+  static void block_vector(const float* __restrict A, int lda, const float* __restrict B, int ldb,
+                           float* __restrict C, int ldc, float alpha, float beta, int i0, int j0) {
+    typedef typename VecRow<NR>::type Row;
+    Row acc[MR] = {};
+    for (int k = 0; k < K; ++k) {
+      Row b;
+      __builtin_memcpy(&b, B + k * ldb + j0, sizeof b);
+#pragma GCC unroll 8
+      for (int r = 0; r < MR; ++r) acc[r] += a_at(A, lda, i0 + r, k) * b;
+    }
+#pragma GCC unroll 8
+    for (int r = 0; r < MR; ++r) {
+      float* Cr = C + (i0 + r) * ldc + j0;
+      Row c = alpha * acc[r];
+      if (beta != 0.0f) {
+        Row old;
+        __builtin_memcpy(&old, Cr, sizeof old);
+        c += beta * old;
+      }
+      __builtin_memcpy(Cr, &c, sizeof c);
+    }
+  }
+
+  static void run(const float* A, int lda, const float* B, int ldb,
+                  float* C, int ldc, float alpha, float beta) {
+    if constexpr (vector_path && TB) {
+      // Rows of op(B) must be contiguous for vector loads: transpose B once (<= 4 KiB for 32x32)
+      alignas(64) float bt[K * N];
+      for (int k = 0; k < K; ++k)
+        for (int j = 0; j < N; ++j) bt[k * N + j] = B[j * ldb + k];
+      FixedSgemm<M, N, K, TA, false>::run(A, lda, bt, N, C, ldc, alpha, beta);
+    } else {
+      for (int i0 = 0; i0 < M; i0 += MR)
+        for (int j0 = 0; j0 < N; j0 += NR) {
+          if constexpr (vector_path) block_vector(A, lda, B, ldb, C, ldc, alpha, beta, i0, j0);
+          else                       block_scalar(A, lda, B, ldb, C, ldc, alpha, beta, i0, j0);
+        }
+    }
+  }
+};
+
+} // namespace plain_fixed
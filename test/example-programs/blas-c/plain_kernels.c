@@ -0,0 +1,110 @@
+#define _GNU_SOURCE 1
+
+#include "plain_kernels.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#  include <immintrin.h>
+#  define PLAIN_HAVE_X86 1
+#endif
+
+// All kernels keep the vector dimension along the columns of C, so a tile row
+// is one contiguous vector in row-major C and can be loaded/stored directly.
+
+// --- Generic (portable C, relies on auto-vectorization) ---
+#define GENERIC_MR 6
+#define GENERIC_NR 8
+
+static void ukernel_generic_6x8(int kc, const float* restrict a, const float* restrict b,
+                                float* restrict C, size_t ldc, int accumulate) {
+  float ab[GENERIC_MR][GENERIC_NR];
+  for (int i = 0; i < GENERIC_MR; ++i)
+    for (int j = 0; j < GENERIC_NR; ++j) ab[i][j] = 0.0f;
+
+  for (int k = 0; k < kc; ++k) {
+    for (int i = 0; i < GENERIC_MR; ++i) {
+      const float ai = a[i];
+      for (int j = 0; j < GENERIC_NR; ++j) ab[i][j] += ai * b[j];
+    }
+    a += GENERIC_MR;
+    b += GENERIC_NR;
+  }
+
+  for (int i = 0; i < GENERIC_MR; ++i) {
+    float* Ci = C + (size_t)i * ldc;
+    if (accumulate) for (int j = 0; j < GENERIC_NR; ++j) Ci[j] += ab[i][j];
+    else            for (int j = 0; j < GENERIC_NR; ++j) Ci[j]  = ab[i][j];
+  }
+}
+
+#ifdef PLAIN_HAVE_X86
+// --- AVX2 + FMA: 6 rows x 8 columns (one ymm per row) ---
+__attribute__((target("avx2,fma")))
+static void ukernel_avx2_6x8(int kc, const float* restrict a, const float* restrict b,
+                             float* restrict C, size_t ldc, int accumulate) {
+  __m256 c0 = _mm256_setzero_ps(), c1 = _mm256_setzero_ps(), c2 = _mm256_setzero_ps();
+  __m256 c3 = _mm256_setzero_ps(), c4 = _mm256_setzero_ps(), c5 = _mm256_setzero_ps();
+
+  for (int k = 0; k < kc; ++k) {
+    const __m256 bv = _mm256_loadu_ps(b);
+    c0 = _mm256_fmadd_ps(_mm256_broadcast_ss(a + 0), bv, c0);
+    c1 = _mm256_fmadd_ps(_mm256_broadcast_ss(a + 1), bv, c1);
+    c2 = _mm256_fmadd_ps(_mm256_broadcast_ss(a + 2), bv, c2);
+    c3 = _mm256_fmadd_ps(_mm256_broadcast_ss(a + 3), bv, c3);
+    c4 = _mm256_fmadd_ps(_mm256_broadcast_ss(a + 4), bv, c4);
+    c5 = _mm256_fmadd_ps(_mm256_broadcast_ss(a + 5), bv, c5);
+    a += 6;
+    b += 8;
+  }
+
+  __m256 acc[6] = { c0, c1, c2, c3, c4, c5 };
+  for (int i = 0; i < 6; ++i) {
+    float* Ci = C + (size_t)i * ldc;
+    if (accumulate) acc[i] = _mm256_add_ps(acc[i], _mm256_loadu_ps(Ci));
+    _mm256_storeu_ps(Ci, acc[i]);
+  }
+}
+
+// --- AVX-512F: 14 rows x 16 columns (one zmm per row) ---
+__attribute__((target("avx512f")))
+static void ukernel_avx512_14x16(int kc, const float* restrict a, const float* restrict b,
+                                 float* restrict C, size_t ldc, int accumulate) {
+  __m512 c[14];
+  for (int i = 0; i < 14; ++i) c[i] = _mm512_setzero_ps();
+
+  for (int k = 0; k < kc; ++k) {
+    const __m512 bv = _mm512_loadu_ps(b);
+    // Fully unrolled by the compiler: 14 broadcast-FMAs per k, accumulators stay in zmm0..13.
+    for (int i = 0; i < 14; ++i) c[i] = _mm512_fmadd_ps(_mm512_set1_ps(a[i]), bv, c[i]);
+    a += 14;
+    b += 16;
+  }
+
+  for (int i = 0; i < 14; ++i) {
+    float* Ci = C + (size_t)i * ldc;
+    if (accumulate) c[i] = _mm512_add_ps(c[i], _mm512_loadu_ps(Ci));
+    _mm512_storeu_ps(Ci, c[i]);
+  }
+}
+#endif
+
+static const PlainKernel kernel_generic = { "generic-6x8",  GENERIC_MR, GENERIC_NR, ukernel_generic_6x8 };
+#ifdef PLAIN_HAVE_X86
+static const PlainKernel kernel_avx2    = { "avx2-fma-6x8", 6,  8,  ukernel_avx2_6x8 };
+static const PlainKernel kernel_avx512  = { "avx512f-14x16", 14, 16, ukernel_avx512_14x16 };
+#endif
+
+const PlainKernel* plain_kernel_select(void) {
+  const char* force = getenv("BLAS_PLAIN_KERNEL");
+  if (force && strcmp(force, "generic") == 0) return &kernel_generic;
+#ifdef PLAIN_HAVE_X86
+  __builtin_cpu_init();
+  const int has_avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+  const int has_avx512 = __builtin_cpu_supports("avx512f");
+  if (force && strcmp(force, "avx2") == 0 && has_avx2) return &kernel_avx2;
+  if (has_avx512) return &kernel_avx512;
+  if (has_avx2) return &kernel_avx2;
+#endif
+  return &kernel_generic;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// SGEMM micro-kernel used by the plain backend.
+// Computes an mr x nr tile of row-major C (leading dimension ldc):
+//   C (+)= a_sliver * b_sliver, summed over kc
+// a: packed A sliver, kc x mr (k-major: a[k*mr + i] is row i)
+// b: packed B sliver, kc x nr (k-major: b[k*nr + j] is column j)
+// accumulate == 0 overwrites C, otherwise adds to it.
+typedef void (*plain_ukernel_fn)(int kc, const float* a, const float* b,
+                                 float* C, size_t ldc, int accumulate);
+
+typedef struct PlainKernel {
+  const char* name;  // reported in the engine JSON, e.g. "avx2-fma-6x8"
+  int mr;            // rows of C per tile (broadcast from packed A)
+  int nr;            // columns of C per tile (vector loaded from packed B)
+  plain_ukernel_fn ukernel;
+} PlainKernel;
+
+// Largest tile any kernel uses; sizes scratch buffers for edge tiles.
+#define PLAIN_MAX_MR 14
+#define PLAIN_MAX_NR 16
+
+// Picks the best micro-kernel for the running CPU (via __builtin_cpu_supports).
+// The environment variable BLAS_PLAIN_KERNEL=generic|avx2|avx512 forces a kernel,
+// falling back to the best supported one if the CPU lacks the requested ISA.
+const PlainKernel* plain_kernel_select(void);
+
+#ifdef __cplusplus
+}
+#endif
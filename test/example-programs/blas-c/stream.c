@@ -0,0 +1,161 @@
+#define _GNU_SOURCE 1
+
+#include "stream.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define STREAM_PASSES 10                     // timed passes per kernel, the best one counts
+#define STREAM_PASS_BYTES ((size_t)64 << 20) // minimum traffic per pass, so small sets outlast the barriers
+#define STREAM_MAX_THREADS 256
+
+static double now_sec(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+typedef struct StreamJob {
+  size_t n;                  // elements per array
+  int threads;
+  int inner;                 // kernel sweeps per pass
+  double* a;
+  double* b;
+  double* c;
+  pthread_mutex_t mu;        // `ready` opens once the number of threads (and the barrier) is known
+  pthread_cond_t cv;
+  int ready;
+  pthread_barrier_t barrier;
+  double best[2];            // seconds per pass: copy, triad (written by thread 0)
+} StreamJob;
+
+typedef struct StreamWorker {
+  StreamJob* job;
+  int id;
+  pthread_t thread;
+} StreamWorker;
+
+static void copy_kernel(double* __restrict c, const double* __restrict a, size_t n) {
+  for (size_t i = 0; i < n; ++i) c[i] = a[i];
+}
+
+static void triad_kernel(double* __restrict a, const double* __restrict b, const double* __restrict c, double s, size_t n) {
+  for (size_t i = 0; i < n; ++i) a[i] = b[i] + s * c[i];
+}
+
+static void* stream_main(void* arg) {
+  const StreamWorker* w = (const StreamWorker*)arg;
+  StreamJob* job = w->job;
+  pthread_mutex_lock(&job->mu);
+  while (!job->ready) pthread_cond_wait(&job->cv, &job->mu);
+  pthread_mutex_unlock(&job->mu);
+  const size_t i0 = job->n * w->id / job->threads, i1 = job->n * (w->id + 1) / job->threads;
+  double* a = job->a + i0;
+  double* b = job->b + i0;
+  double* c = job->c + i0;
+  const size_t n = i1 - i0;
+  for (size_t i = 0; i < n; ++i) { a[i] = 1.0; b[i] = 2.0; c[i] = 0.0; } // first touch
+
+  for (int kernel = 0; kernel < 2; ++kernel) {
+    for (int pass = -1; pass < STREAM_PASSES; ++pass) { // pass -1 warms the caches up
+      pthread_barrier_wait(&job->barrier);
+      const double t0 = now_sec();
+      for (int k = 0; k < job->inner; ++k) {
+        if (kernel == 0) copy_kernel(c, a, n);
+        else triad_kernel(a, b, c, 3.0, n);
+        __asm__ volatile("" ::: "memory"); // keep repeated sweeps from being merged
+      }
+      pthread_barrier_wait(&job->barrier);
+      const double dt = now_sec() - t0;
+      if (w->id == 0 && pass >= 0 && (job->best[kernel] == 0.0 || dt < job->best[kernel])) job->best[kernel] = dt;
+    }
+  }
+  return NULL;
+}
+
+int stream_measure(size_t working_set, int threads, StreamResult* out) {
+  memset(out, 0, sizeof *out);
+  if (threads < 1) threads = 1;
+  if (threads > STREAM_MAX_THREADS) threads = STREAM_MAX_THREADS;
+  StreamJob job;
+  memset(&job, 0, sizeof job);
+  job.n = working_set / (3 * sizeof(double));
+  if (job.n < (size_t)threads * 8) job.n = (size_t)threads * 8;
+  job.inner = (int)((STREAM_PASS_BYTES + working_set - 1) / working_set);
+  if (job.inner < 1) job.inner = 1;
+  if (posix_memalign((void**)&job.a, 64, job.n * sizeof(double)) != 0) return 1;
+  if (posix_memalign((void**)&job.b, 64, job.n * sizeof(double)) != 0) { free(job.a); return 1; }
+  if (posix_memalign((void**)&job.c, 64, job.n * sizeof(double)) != 0) { free(job.a); free(job.b); return 1; }
+
+  StreamWorker workers[STREAM_MAX_THREADS];
+  pthread_mutex_init(&job.mu, NULL);
+  pthread_cond_init(&job.cv, NULL);
+  // Worker 0 is the calling thread; if fewer threads start, the others share the arrays
+  int started = 1;
+  for (int t = 0; t < threads; ++t) { workers[t].job = &job; workers[t].id = t; }
+  for (; started < threads; ++started) {
+    if (pthread_create(&workers[started].thread, NULL, stream_main, &workers[started]) != 0) break;
+  }
+  pthread_mutex_lock(&job.mu);
+  job.threads = started;
+  pthread_barrier_init(&job.barrier, NULL, (unsigned)started);
+  job.ready = 1;
+  pthread_cond_broadcast(&job.cv);
+  pthread_mutex_unlock(&job.mu);
+  stream_main(&workers[0]);
+  for (int t = 1; t < started; ++t) pthread_join(workers[t].thread, NULL);
+  pthread_barrier_destroy(&job.barrier);
+  pthread_cond_destroy(&job.cv);
+  pthread_mutex_destroy(&job.mu);
+
+  const double bytes = (double)job.n * sizeof(double) * job.inner;
+  out->threads = job.threads;
+  out->copy_gbs = 2.0 * bytes / job.best[0] * 1e-9;
+  out->triad_gbs = 3.0 * bytes / job.best[1] * 1e-9;
+  free(job.a); free(job.b); free(job.c);
+  return 0;
+}
+
+size_t stream_cache_size(int level) {
+  char path[128], buf[64];
+  for (int index = 0; index < 16; ++index) {
+    snprintf(path, sizeof path, "/sys/devices/system/cpu/cpu0/cache/index%d/level", index);
+    FILE* f = fopen(path, "r");
+    if (!f) break;
+    const int lvl = fgets(buf, sizeof buf, f) ? atoi(buf) : 0;
+    fclose(f);
+    if (lvl != level) continue;
+    snprintf(path, sizeof path, "/sys/devices/system/cpu/cpu0/cache/index%d/type", index);
+    f = fopen(path, "r");
+    const int is_instruction = f && fgets(buf, sizeof buf, f) && strncmp(buf, "Instruction", 11) == 0;
+    if (f) fclose(f);
+    if (is_instruction) continue;
+    snprintf(path, sizeof path, "/sys/devices/system/cpu/cpu0/cache/index%d/size", index);
+    f = fopen(path, "r");
+    if (!f) continue;
+    char* end = NULL;
+    size_t size = fgets(buf, sizeof buf, f) ? strtoul(buf, &end, 10) : 0;
+    fclose(f);
+    if (end && *end == 'K') size <<= 10;
+    else if (end && *end == 'M') size <<= 20;
+    return size;
+  }
+  return 0;
+}
+
+const char* stream_cache_level(size_t bytes) {
+  static const char* names[] = { "L1", "L2", "L3" };
+  for (int level = 1; level <= 3; ++level) {
+    const size_t size = stream_cache_size(level);
+    if (size > 0 && bytes <= size) return names[level - 1];
+  }
+  return "DRAM";
+}
+
+int stream_default_threads(void) {
+  cpu_set_t allowed;
+  return sched_getaffinity(0, sizeof allowed, &allowed) == 0 ? CPU_COUNT(&allowed) : 1;
+}
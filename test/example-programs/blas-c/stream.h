@@ -0,0 +1,33 @@
+#pragma once
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// STREAM-style bandwidth baseline (McCalpin's copy and triad on doubles), measured at a given
+// working set so memory-bound BLAS kernels can be compared with what the memory system delivers.
+
+typedef struct StreamResult {
+  int threads;
+  double copy_gbs;   // c[i] = a[i]: 16 bytes per element
+  double triad_gbs;  // a[i] = b[i] + s*c[i]: 24 bytes per element
+} StreamResult;
+
+// Runs copy and triad on three arrays of `working_set / 24` doubles (split over `threads`
+// threads, each first-touching its own slice) and reports the best of several timed passes.
+// Like STREAM, bytes are counted without write-allocate traffic. Returns 0 on success.
+int stream_measure(size_t working_set, int threads, StreamResult* out);
+
+// Size in bytes of the level-`level` (1..3) data or unified cache of CPU 0, 0 if unknown (sysfs)
+size_t stream_cache_size(int level);
+
+// "L1", "L2", "L3" for the smallest cache level holding `bytes`, "DRAM" otherwise
+const char* stream_cache_level(size_t bytes);
+
+// CPUs in the affinity mask of the calling thread
+int stream_default_threads(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,4 +1,10 @@
-{ stdenv, blas-test, m ? 2048, n ? 2048, iterations ? 10, spoofGpu ? null }:
+{ stdenv, lib, blas-test, m ? 2048, n ? 2048, iterations ? 10, spoofGpu ? null,
+  sweep ? false,    # Run the built-in shape grid (--sweep); result.json is then a JSON array
+  extraArgs ? [],   # Further blas-test-c options, e.g. [ "--precision=d" "--transa=t" ]
+}:
+let
+    args = lib.escapeShellArgs (extraArgs ++ lib.optional sweep "--sweep" ++ [ (toString m) (toString n) (toString iterations) ]);
+in
 stdenv.mkDerivation {
   name = "blas-test-result";
   version = "1.0.0";
@@ -10,13 +16,13 @@ stdenv.mkDerivation {
     if (spoofGpu != null) then
         ''
         set +e
-        HSA_OVERRIDE_GFX_VERSION='${spoofGpu}' ${blas-test}/bin/blas-test-c ${toString m} ${toString n} ${toString iterations} | tee result.json
+        HSA_OVERRIDE_GFX_VERSION='${spoofGpu}' ${blas-test}/bin/blas-test-c ${args} | tee result.json
         set -e
         ''
     else
         ''
         set +e
-        ${blas-test}/bin/blas-test-c ${toString m} ${toString n} ${toString iterations} | tee result.json
+        ${blas-test}/bin/blas-test-c ${args} | tee result.json
         set -e
         '';
 
@@ -24,4 +30,4 @@ stdenv.mkDerivation {
     mkdir -p $out/lib
     cp *.json $out/lib
   '';
-}
\ No newline at end of file
+}
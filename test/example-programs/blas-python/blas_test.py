@@ -5,6 +5,7 @@ import sys
 import time
 import os
 import argparse
+import ctypes
 
 try:
     import numpy as np
@@ -22,17 +23,61 @@ except Exception:
     torch = None  # sentinel; handled at runtime
 
 
-def init_matrix(rows: int, cols: int, seed: int) -> np.ndarray:
-    # Deterministic low-overhead LCG similar to C/Fortran examples
-    x = seed if seed != 0 else 1
-    total = rows * cols
-    out = np.empty((rows, cols), dtype=np.float32)
-    # Fill row-major, but NumPy is C-order by default; BLAS expects Fortran-order.
-    # We'll allocate Fortran-order arrays later; use a temporary 1D view here and reshape.
-    buf = out.ravel()
-    for i in range(total):
-        x = (1664525 * x + 1013904223) & 0x7FFFFFFF  # keep it positive 31-bit
-        buf[i] = ((x >> 8) & 0xFFFF) / 32768.0 - 1.0
+LCG_A = 1664525
+LCG_C = 1013904223
+LCG_MASK = 0x7FFFFFFF      # the state stays a positive 31-bit integer
+LCG_BLOCK = 1 << 16        # values per vectorized step
+
+
+def lcg_jump_tables(n: int) -> tuple[np.ndarray, np.ndarray]:
+    # mul[j], add[j] such that x_{j+1} = (mul[j] * x_0 + add[j]) & LCG_MASK, for j in [0, n).
+    # Built by doubling: the second half continues from x_m = mul[m-1] * x_0 + add[m-1].
+    # All factors stay below 2^31, so the products fit into uint64.
+    mul = np.array([LCG_A], dtype=np.uint64)
+    add = np.array([LCG_C], dtype=np.uint64)
+    while mul.size < n:
+        m_last, a_last = mul[-1], add[-1]
+        mul = np.concatenate((mul, (mul * m_last) & LCG_MASK))
+        add = np.concatenate((add, (mul[:add.size] * a_last + add) & LCG_MASK))
+    return mul[:n], add[:n]
+
+
+def lcg_values(count: int, seed: int) -> np.ndarray:
+    # The first `count` values of the LCG as float32, block by block: every block of LCG_BLOCK
+    # states is one vectorized jump-ahead from the last state of the previous block
+    mul, add = lcg_jump_tables(min(count, LCG_BLOCK))
+    out = np.empty(count, dtype=np.float32)
+    x = np.uint64(seed if seed != 0 else 1)
+    for start in range(0, count, LCG_BLOCK):
+        n = min(LCG_BLOCK, count - start)
+        states = (mul[:n] * x + add[:n]) & LCG_MASK
+        out[start:start + n] = ((states >> 8) & 0xFFFF).astype(np.float32) / np.float32(32768.0) - np.float32(1.0)
+        x = states[-1]
+    return out
+
+
+def init_matrix(rows: int, cols: int, seed: int, cache_dir: str | None = None) -> np.ndarray:
+    # Deterministic low-overhead LCG similar to C/Fortran examples, filled row-major (C order).
+    # With `cache_dir` the matrix is stored there as .npy once and memory-mapped (read-only) afterwards.
+    path = os.path.join(cache_dir, f"lcg-{rows}x{cols}-seed{seed}.npy") if cache_dir else None
+    if path and os.path.exists(path):
+        try:
+            cached = np.load(path, mmap_mode="r")
+            if cached.shape == (rows, cols) and cached.dtype == np.float32:
+                return cached
+        except (OSError, ValueError):
+            pass  # unreadable or truncated: regenerate below
+    out = lcg_values(rows * cols, seed).reshape(rows, cols)
+    if path:
+        try:
+            os.makedirs(cache_dir, exist_ok=True)
+            # Written under a temporary name and renamed, so concurrent runs never see half a file
+            tmp = f"{path}.{os.getpid()}.tmp"
+            with open(tmp, "wb") as f:
+                np.save(f, out)
+            os.replace(tmp, path)
+        except OSError as e:
+            print(f"Cannot cache input matrix in {cache_dir}: {e}", file=sys.stderr)
     return out
 
 
@@ -48,8 +93,61 @@ def checksum_torch(t: "torch.Tensor") -> float:
     return float(t.sum(dtype=t.dtype).detach().cpu().item())
 
 
-def print_json(engine_name: str, engine_version: str, M: int, N: int, K: int, repeats: int,
-               error: str | None, secs: float | None, csum: float | None) -> None:
+CBLAS_COL_MAJOR = 102
+CBLAS_NO_TRANS = 111
+# Exported names of cblas_sgemm; the 64_ variants belong to ILP64 builds (64-bit dimensions),
+# e.g. the scipy-openblas64 library bundled with NumPy wheels
+CBLAS_SGEMM_SYMBOLS = ["cblas_sgemm", "cblas_sgemm64_", "scipy_cblas_sgemm64_", "scipy_cblas_sgemm"]
+
+
+def find_cblas_sgemm() -> tuple[object, str, str] | None:
+    # cblas_sgemm of the BLAS library NumPy has already loaded into this process, looked up in the
+    # shared objects of /proc/self/maps: NumPy's own bundled libraries first, then BLAS-looking
+    # names; Python extension modules (e.g. SciPy's wrappers) are skipped. Returns (function, path, symbol).
+    paths: list[str] = []
+    try:
+        with open("/proc/self/maps") as f:
+            for line in f:
+                fields = line.split()
+                if len(fields) >= 6 and ".so" in fields[5] and ".cpython-" not in fields[5] and fields[5] not in paths:
+                    paths.append(fields[5])
+    except OSError:
+        return None
+    numpy_dir = os.path.dirname(os.path.dirname(np.__file__))
+    paths.sort(key=lambda p: (0 if p.startswith(os.path.join(numpy_dir, "numpy")) else 1,
+                              0 if any(k in os.path.basename(p).lower() for k in ("blas", "blis", "mkl")) else 1))
+    for path in paths:
+        try:
+            lib = ctypes.CDLL(path)
+        except OSError:
+            continue
+        for symbol in CBLAS_SGEMM_SYMBOLS:
+            fn = getattr(lib, symbol, None)
+            if fn is None:
+                continue
+            int_t = ctypes.c_int64 if symbol.endswith("64_") else ctypes.c_int
+            fn.restype = None
+            fn.argtypes = [ctypes.c_int, ctypes.c_int, ctypes.c_int, int_t, int_t, int_t,
+                           ctypes.c_float, ctypes.c_void_p, int_t, ctypes.c_void_p, int_t,
+                           ctypes.c_float, ctypes.c_void_p, int_t]
+            return fn, path, symbol
+    return None
+
+
+def c_result_per_call(path: str, M: int, N: int, K: int) -> float | None:
+    # Seconds per GEMM of a blas-test-c JSON result (object or array) with the same M, N, K
+    results = json.load(open(path))
+    for r in results if isinstance(results, list) else [results]:
+        inp, out = r.get("input", {}), r.get("output", {})
+        if (inp.get("M"), inp.get("N"), inp.get("K")) == (M, N, K) and out.get("time_sec") and inp.get("repeats"):
+            return out["time_sec"] / inp["repeats"]
+    return None
+
+
+def result_json(engine_name: str, engine_version: str, M: int, N: int, K: int, repeats: int,
+                error: str | None, secs: float | None, csum: float | None,
+                setup_secs: float | None = None, engine_extra: dict | None = None,
+                output_extra: dict | None = None) -> dict:
     bytes_per = 4  # float32
     szA = M * K * bytes_per
     szB = K * N * bytes_per
@@ -62,6 +160,8 @@ def print_json(engine_name: str, engine_version: str, M: int, N: int, K: int, re
     }
     if engine_version:
         obj["engine"]["version"] = engine_version
+    if engine_extra:
+        obj["engine"].update(engine_extra)
 
     obj["input"] = {
         "M": M,
@@ -82,8 +182,16 @@ def print_json(engine_name: str, engine_version: str, M: int, N: int, K: int, re
             "gflops": float(f"{gflops:.2f}"),
             "checksum": float(f"{(csum or 0.0):.6f}")
         }
+        if setup_secs is not None:
+            # Generating (or loading) A and B, outside the timed region
+            obj["output"]["setup_sec"] = float(f"{setup_secs:.6f}")
+        if output_extra:
+            obj["output"].update(output_extra)
+    return obj
+
 
-    json.dump(obj, sys.stdout)
+def print_json(*args, **kwargs) -> None:
+    json.dump(result_json(*args, **kwargs), sys.stdout)
     sys.stdout.write("\n")
 
 
@@ -93,6 +201,13 @@ def main(argv: list[str]) -> int:
     parser.add_argument("K", nargs="?", type=int, default=2048)
     parser.add_argument("repeats", nargs="?", type=int, default=50)
     parser.add_argument("--backend", choices=["auto", "cpu", "gpu"], default=os.environ.get("BLAS_BACKEND", "auto"))
+    parser.add_argument("--cache-dir", default=os.environ.get("BLAS_TEST_CACHE_DIR"),
+                        help="keep the input matrices here as .npy files and memory-map them on later runs")
+    parser.add_argument("--mode", default="matmul",
+                        help="CPU call path(s), comma-separated: matmul (np.matmul), scipy (scipy.linalg.blas.sgemm), "
+                             "ctypes (cblas_sgemm of NumPy's BLAS), or all")
+    parser.add_argument("--c-result", default=None,
+                        help="blas-test-c JSON result with the same M, N, K: call_overhead_sec is relative to its time per call")
     args = parser.parse_args(argv[1:])
 
     N = args.N
@@ -104,21 +219,89 @@ def main(argv: list[str]) -> int:
         return 1
 
     M = N
+    if args.mode != "all" and any(m not in ("matmul", "scipy", "ctypes") for m in args.mode.split(",")):
+        print(f"Unknown --mode={args.mode}", file=sys.stderr)
+        return 1
 
-    # CPU path (NumPy/BLAS)
+    # CPU path (NumPy/BLAS). Every mode runs C = A x B on the same Fortran-ordered buffers, so
+    # the differences between them are the per-call overhead of the Python layer in front of BLAS.
     def run_cpu():
-        A = np.asfortranarray(init_matrix(M, K, 1), dtype=np.float32)
-        B = np.asfortranarray(init_matrix(K, N, 2), dtype=np.float32)
+        t_setup = time.perf_counter()
+        A = np.asfortranarray(init_matrix(M, K, 1, args.cache_dir), dtype=np.float32)
+        B = np.asfortranarray(init_matrix(K, N, 2, args.cache_dir), dtype=np.float32)
+        setup_secs = time.perf_counter() - t_setup
         C = np.asfortranarray(np.zeros((M, N), dtype=np.float32))
-        # Warmup
-        np.matmul(A, B, out=C)
-        t0 = time.perf_counter()
-        for _ in range(repeats):
-            np.matmul(A, B, out=C)
-        t1 = time.perf_counter()
-        secs = t1 - t0
-        csum = checksum_np(C)
-        print_json("NumPy", getattr(np, "__version__", ""), M, N, K, repeats, None, secs, csum)
+
+        def timed(call) -> float:
+            call()  # warmup
+            t0 = time.perf_counter()
+            for _ in range(repeats):
+                call()
+            return time.perf_counter() - t0
+
+        def run_matmul() -> dict:
+            secs = timed(lambda: np.matmul(A, B, out=C))
+            return {"args": ("NumPy", getattr(np, "__version__", "")), "secs": secs}
+
+        def run_scipy() -> dict:
+            try:
+                import scipy  # type: ignore
+                from scipy.linalg import blas as scipy_blas  # type: ignore
+            except Exception as e:
+                return {"args": ("SciPy", ""), "error": f"Failed to import scipy: {e}"}
+            # With Fortran-ordered float32 operands and overwrite_c, f2py passes all three buffers
+            # through and sgemm writes into C itself; zero_copy reports whether that happened
+            out = scipy_blas.sgemm(1.0, A, B, beta=0.0, c=C, overwrite_c=1)
+            zero_copy = np.shares_memory(out, C)
+            secs = timed(lambda: scipy_blas.sgemm(1.0, A, B, beta=0.0, c=C, overwrite_c=1))
+            return {"args": ("SciPy", getattr(scipy, "__version__", "")), "secs": secs,
+                    "engine": {"function": "scipy.linalg.blas.sgemm"}, "output": {"zero_copy": bool(zero_copy)},
+                    "result": None if zero_copy else out}
+
+        def run_ctypes() -> dict:
+            found = find_cblas_sgemm()
+            if found is None:
+                return {"args": ("CBLAS", ""), "error": "no cblas_sgemm in the libraries loaded by NumPy"}
+            fn, path, symbol = found
+            a, b, c = A.ctypes.data, B.ctypes.data, C.ctypes.data
+            secs = timed(lambda: fn(CBLAS_COL_MAJOR, CBLAS_NO_TRANS, CBLAS_NO_TRANS, M, N, K,
+                                    1.0, a, M, b, K, 0.0, c, M))
+            return {"args": ("CBLAS", ""), "secs": secs, "engine": {"function": symbol, "library": path}}
+
+        runners = {"matmul": run_matmul, "scipy": run_scipy, "ctypes": run_ctypes}
+        modes = list(runners) if args.mode == "all" else args.mode.split(",")
+        # The reference for call_overhead_sec: the C program's time per call if given, otherwise the
+        # ctypes mode, a call straight into the same library (costing only the argument conversion)
+        ref_per_call, ref_name = None, None
+        if args.c_result:
+            try:
+                ref_per_call, ref_name = c_result_per_call(args.c_result, M, N, K), "blas-c"
+            except (OSError, ValueError) as e:
+                print(f"Cannot read {args.c_result}: {e}", file=sys.stderr)
+        runs = []
+        for mode in modes:
+            C.fill(0.0)
+            run = runners[mode]()
+            run["mode"] = mode
+            if "secs" in run:
+                result = run.pop("result", None)
+                run["csum"] = checksum_np(C if result is None else result)
+            runs.append(run)
+        ctypes_run = next((r for r in runs if r["mode"] == "ctypes" and "secs" in r), None)
+        if ref_per_call is None and ctypes_run is not None:
+            ref_per_call, ref_name = ctypes_run["secs"] / repeats, "ctypes"
+
+        results = []
+        for run in runs:
+            output = dict(run.get("output", {}))
+            if "secs" in run and ref_per_call is not None and not (run["mode"] == "ctypes" and ref_name == "ctypes"):
+                output["call_overhead_sec"] = float(f"{run['secs'] / repeats - ref_per_call:.9f}")
+                output["overhead_reference"] = ref_name
+            results.append(result_json(*run["args"], M, N, K, repeats, run.get("error"), run.get("secs"),
+                                       run.get("csum"), setup_secs, dict(run.get("engine", {}), mode=run["mode"]),
+                                       output))
+        json.dump(results if len(results) > 1 else results[0], sys.stdout)
+        sys.stdout.write("\n")
 
     # GPU path (PyTorch CUDA/ROCm)
     def run_gpu():
@@ -155,8 +338,10 @@ def main(argv: list[str]) -> int:
         device = torch.device("cuda")
         dtype = torch.float32
         # Prepare host arrays using same generator for determinism
-        A_h = init_matrix(M, K, 1).astype(np.float32, copy=False)
-        B_h = init_matrix(K, N, 2).astype(np.float32, copy=False)
+        t_setup = time.perf_counter()
+        A_h = init_matrix(M, K, 1, args.cache_dir).astype(np.float32, copy=False)
+        B_h = init_matrix(K, N, 2, args.cache_dir).astype(np.float32, copy=False)
+        setup_secs = time.perf_counter() - t_setup
         # Upload once
         A = torch.from_numpy(np.ascontiguousarray(A_h)).to(device=device, dtype=dtype)
         B = torch.from_numpy(np.ascontiguousarray(B_h)).to(device=device, dtype=dtype)
@@ -172,7 +357,7 @@ def main(argv: list[str]) -> int:
         t1 = time.perf_counter()
         secs = t1 - t0
         csum = checksum_torch(C)
-        print_json("PyTorch", getattr(torch, "__version__", ""), M, N, K, repeats, None, secs, csum)
+        print_json("PyTorch", getattr(torch, "__version__", ""), M, N, K, repeats, None, secs, csum, setup_secs)
 
     # Decide backend
     backend = args.backend
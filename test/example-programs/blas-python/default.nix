@@ -1,7 +1,9 @@
-{ python3Packages, enableTorch ? false }:
+{ python3Packages, enableTorch ? false
+, enableScipy ? false   # --mode=scipy: call sgemm through scipy.linalg.blas
+}:
 with python3Packages;
 let
-  pythonEnv = python.withPackages (ps: [ ps.numpy ] ++ (if enableTorch then [ ps.pytorch ] else []));
+  pythonEnv = python.withPackages (ps: [ ps.numpy ] ++ (if enableTorch then [ ps.pytorch ] else []) ++ (if enableScipy then [ ps.scipy ] else []));
 in
 buildPythonApplication {
   pname = "blas-test-python";
@@ -11,7 +13,7 @@ buildPythonApplication {
   format = "other";
 
   # Keep explicit inputs for completeness; shebang will point to pythonEnv
-  buildInputs = [ numpy ] ++ (if enableTorch then [ pytorch ] else []);
+  buildInputs = [ numpy ] ++ (if enableTorch then [ pytorch ] else []) ++ (if enableScipy then [ scipy ] else []);
 
   outputs = [ "out" ];
 
@@ -1,4 +1,9 @@
-{ stdenv, blas-test, m ? 2048, n ? 2048, iterations ? 10 }:
+{ stdenv, lib, blas-test, m ? 2048, n ? 2048, iterations ? 10,
+  extraArgs ? [],   # Further blas-test-py options, e.g. [ "--mode=all" ]
+}:
+let
+    args = lib.escapeShellArgs (extraArgs ++ [ (toString m) (toString n) (toString iterations) ]);
+in
 stdenv.mkDerivation {
   name = "blas-test-python-result";
   version = "1.0.0";
@@ -8,7 +13,7 @@ stdenv.mkDerivation {
 
   buildPhase = ''
     set +e
-    ${blas-test}/bin/blas-test-py ${toString m} ${toString n} ${toString iterations} >result.json
+    ${blas-test}/bin/blas-test-py ${args} >result.json
     set -e
   '';
 
@@ -6,8 +6,18 @@
  * If you want to embed the exact gcc command that built this binary, compile with:
  *   gcc ... -DCC_ARGS="\"gcc <your flags here>\"" buildinfo.c -o buildinfo
  * (Optional; safe to omit.)
+ *
+ * To report which glibc-hwcaps variant of a shared library the dynamic loader picks, compile with
+ *   -DBUILDINFO_HWCAPS_PROBE="\"libcblas.so.3:libpython3.12.so.1.0\"" -Wl,-rpath,<their lib dirs> -ldl
+ * The listed libraries are dlopen()ed at runtime, so they are found like a DT_NEEDED entry would be.
+ *
+ * Built with the withTargetClones stdenv, it also reports which function clone (ZEN_TARGET_CLONE_ARCHS) runs here.
  */
 
+#ifdef BUILDINFO_HWCAPS_PROBE
+  #define _GNU_SOURCE 1            /* dlinfo() */
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -17,6 +27,13 @@
 #if defined(__GLIBC__)
   #include <gnu/libc-version.h>    /* for gnu_get_libc_version/release() */
 #endif
+#ifdef BUILDINFO_HWCAPS_PROBE
+  #include <dlfcn.h>               /* dlopen(), dlinfo() */
+  #include <link.h>                /* struct link_map */
+#endif
+#ifdef ZEN_TARGET_CLONE_ARCHS
+  #include <zen-target-clones.h> /* zen_target_clone_selected() */
+#endif
 
 /* JSON string escaper for safety */
 static void json_escape_and_print(const char *s) {
@@ -70,6 +87,79 @@ static void js_kv_bool(const char *key, int val, int trailing_comma) {
     fputc('\n', stdout);
 }
 
+/* x86-64 micro-architecture levels of this CPU, i.e. the glibc-hwcaps subdirectories the loader searches
+ * (best first). __builtin_cpu_supports() knows them since GCC 12 / Clang 16. */
+static void print_hwcaps_supported(void) {
+    int first = 1;
+    json_escape_and_print("supported");
+    fputs(": [", stdout);
+#if defined(__x86_64__) && (defined(__clang__) ? __clang_major__ >= 16 : (defined(__GNUC__) && __GNUC__ >= 12))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("x86-64-v4")) { fputs("\"x86-64-v4\"", stdout); first = 0; }
+    if (__builtin_cpu_supports("x86-64-v3")) { fputs(first ? "\"x86-64-v3\"" : ", \"x86-64-v3\"", stdout); first = 0; }
+    if (__builtin_cpu_supports("x86-64-v2")) { fputs(first ? "\"x86-64-v2\"" : ", \"x86-64-v2\"", stdout); first = 0; }
+#endif
+    (void)first;
+    fputs("]", stdout);
+}
+
+/* The function clones built in by the withTargetClones stdenv (helper/my-stenv-adapter.nix) and the one the ifunc
+ * resolvers picked on this CPU, as observed on a probe function cloned like the marked code (zen-target-clones.h) */
+static void print_target_clones(void) {
+#ifdef ZEN_TARGET_CLONE_ARCHS
+    char archs[] = ZEN_TARGET_CLONE_ARCHS;
+    int first = 1;
+    json_escape_and_print("archs");
+    fputs(": [", stdout);
+    for (char *arch = strtok(archs, ","); arch; arch = strtok(NULL, ",")) {
+        fputs(first ? "" : ", ", stdout);
+        first = 0;
+        json_escape_and_print(arch);
+    }
+    fputs("],\n", stdout);
+    js_kv_str("selected", zen_target_clone_selected(), 0);
+#else
+    json_escape_and_print("archs");
+    fputs(": [],\n", stdout);
+    js_kv_str("selected", NULL, 0);
+#endif
+}
+
+#ifdef BUILDINFO_HWCAPS_PROBE
+/* One {"library", "path", "variant"} object per library of BUILDINFO_HWCAPS_PROBE: where the loader found it,
+ * and the glibc-hwcaps subdirectory that was ("baseline" for the library directory itself) */
+static void print_hwcaps_probe(void) {
+    char names[] = BUILDINFO_HWCAPS_PROBE;
+    int first = 1;
+    json_escape_and_print("probed");
+    fputs(": [\n", stdout);
+    for (char *name = strtok(names, ":"); name; name = strtok(NULL, ":")) {
+        void *handle = dlopen(name, RTLD_LAZY | RTLD_LOCAL);
+        struct link_map *map = NULL;
+        const char *path = NULL, *variant = NULL;
+        if (handle && dlinfo(handle, RTLD_DI_LINKMAP, &map) == 0 && map) path = map->l_name;
+        char level[32] = "baseline";
+        const char *sub = path ? strstr(path, "/glibc-hwcaps/") : NULL;
+        if (sub) {
+            sub += strlen("/glibc-hwcaps/");
+            size_t len = strcspn(sub, "/");
+            if (len >= sizeof(level)) len = sizeof(level) - 1;
+            memcpy(level, sub, len);
+            level[len] = '\0';
+        }
+        if (path) variant = level;
+        fputs(first ? "" : ",\n", stdout);
+        first = 0;
+        fputs("{\n", stdout);
+        js_kv_str("library", name, 1);
+        js_kv_str("path", path, 1);
+        js_kv_str("variant", variant, 0);
+        fputs("}", stdout);
+    }
+    fputs("\n]", stdout);
+}
+#endif
+
 int main(void) {
     /* --- Compiler block --- */
     fputs("{\n", stdout);
@@ -306,6 +396,22 @@ int main(void) {
     js_kv_str("kind", "unknown_or_non_glibc", 0);
 #endif
 
+    fputs("},\n", stdout);
+
+    /* --- glibc-hwcaps block --- */
+    json_escape_and_print("glibc_hwcaps");
+    fputs(": {\n", stdout);
+    print_hwcaps_supported();
+#ifdef BUILDINFO_HWCAPS_PROBE
+    fputs(",\n", stdout);
+    print_hwcaps_probe();
+#endif
+    fputs("\n},\n", stdout);
+
+    /* --- target_clones block --- */
+    json_escape_and_print("target_clones");
+    fputs(": {\n", stdout);
+    print_target_clones();
     fputs("}\n", stdout);
 
     /* --- Optional: echo argv if you run the binary with args (not gcc’s args) --- */
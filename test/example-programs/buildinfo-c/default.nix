@@ -1,17 +1,24 @@
-{ stdenv }:
-
+{ stdenv, lib
+, hwcapsProbe ? {} # e.g. { "libcblas.so.3" = pkgs.blas; }: report which glibc-hwcaps variant of these gets loaded
+}:
+let
+    probeFlags = lib.optionalString (hwcapsProbe != {}) (lib.escapeShellArgs ([
+        "-DBUILDINFO_HWCAPS_PROBE=\"${lib.concatStringsSep ":" (lib.attrNames hwcapsProbe)}\""
+    ] ++ map (pkg: "-Wl,-rpath,${lib.getLib pkg}/lib") (lib.attrValues hwcapsProbe) ++ [ "-ldl" ]));
+in
 stdenv.mkDerivation {
   name = "buildinfo";
   version = "1.0.0";
   
   src = ./.;
   buildInputs = [];
+  dontPatchELF = hwcapsProbe != {}; # Would shrink away the RUNPATH entries of the (dlopen'ed) probed libraries
 
   buildPhase = ''
     set -eo pipefail
 
-    echo "$CC -o buildinfo buildinfo.c"
-    $CC -o buildinfo buildinfo.c
+    echo "$CC -o buildinfo buildinfo.c ${probeFlags}"
+    $CC -o buildinfo buildinfo.c ${probeFlags}
     echo "Build complete"
 
     echo "CC=$(readlink -f $(command -v $CC))" >>buildinfo.log
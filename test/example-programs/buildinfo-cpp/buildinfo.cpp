@@ -6,6 +6,8 @@
  * If you want to embed the exact g++ command that built this binary, compile with:
  *   g++ ... -DCX_ARGS="\"g++ <your flags here>\"" buildinfo.cpp -o buildinfo
  * (Optional; safe to omit.)
+ *
+ * Built with the withTargetClones stdenv, it also reports which function clone (ZEN_TARGET_CLONE_ARCHS) runs here.
  */
 
 #include <cstdio>
@@ -18,6 +20,9 @@
 #if defined(__GLIBC__)
   #include <gnu/libc-version.h>    /* for gnu_get_libc_version/release() */
 #endif
+#ifdef ZEN_TARGET_CLONE_ARCHS
+  #include <zen-target-clones.h> /* zen_target_clone_selected() */
+#endif
 
 /* JSON string escaper for safety */
 static void json_escape_and_print(const char *s) {
@@ -71,6 +76,28 @@ static void js_kv_bool(const char *key, int val, int trailing_comma) {
     fputc('\n', stdout);
 }
 
+/* The function clones built in by the withTargetClones stdenv (helper/my-stenv-adapter.nix) and the one the ifunc
+ * resolvers picked on this CPU, as observed on a probe function cloned like the marked code (zen-target-clones.h) */
+static void print_target_clones(void) {
+#ifdef ZEN_TARGET_CLONE_ARCHS
+    char archs[] = ZEN_TARGET_CLONE_ARCHS;
+    int first = 1;
+    json_escape_and_print("archs");
+    fputs(": [", stdout);
+    for (char *arch = strtok(archs, ","); arch; arch = strtok(NULL, ",")) {
+        fputs(first ? "" : ", ", stdout);
+        first = 0;
+        json_escape_and_print(arch);
+    }
+    fputs("],\n", stdout);
+    js_kv_str("selected", zen_target_clone_selected(), 0);
+#else
+    json_escape_and_print("archs");
+    fputs(": [],\n", stdout);
+    js_kv_str("selected", NULL, 0);
+#endif
+}
+
 int main() {
     /* --- Compiler block --- */
     fputs("{\n", stdout);
@@ -314,6 +341,12 @@ int main() {
     js_kv_str("kind", "unknown_or_non_glibc", 0);
 #endif
 
+    fputs("},\n", stdout);
+
+    /* --- target_clones block --- */
+    json_escape_and_print("target_clones");
+    fputs(": {\n", stdout);
+    print_target_clones();
     fputs("}\n", stdout);
 
     fputs("}\n", stdout);
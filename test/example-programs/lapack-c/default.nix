@@ -0,0 +1,41 @@
+{ stdenv
+, lib
+, lapack                # e.g. pkgs.lapack (amd-libflame in the tuned overlay), pkgs.lapack-reference, pkgs.amd-libflame
+, blas                  # BLAS the LAPACK provider calls into, e.g. pkgs.blas (amd-blis in the tuned overlay)
+, pkg-config ? null
+}:
+stdenv.mkDerivation {
+  pname = "lapack-test";
+  version = "1.0.0";
+
+  src = ./.;  # expects: main.c
+
+  nativeBuildInputs = [ pkg-config ];
+  buildInputs = [ lapack blas ];
+
+  outputs = [ "out" ];
+
+  buildPhase = ''
+    runHook preBuild
+    mkdir -p build
+    # Fortran LAPACK symbols only (no LAPACKE/headers needed); fall back to common flags without pkg-config
+    LDLIBS_EXTRA="$(pkg-config --libs lapack blas 2>/dev/null || echo "-llapack -lblas")"
+
+    $CC -o build/lapack-test main.c $LDLIBS_EXTRA -ldl
+
+    runHook postBuild
+  '';
+
+  installPhase = ''
+    runHook preInstall
+    install -Dm755 build/lapack-test $out/bin/lapack-test-c
+    runHook postInstall
+  '';
+
+  meta = with lib; {
+    description = "LAPACK factorization benchmark (GETRF/POTRF/GEQRF/SYEVD) printing JSON, provider selected by Nix inputs";
+    license = licenses.mit;
+    platforms = platforms.linux;
+    maintainers = [ ];
+  };
+}
@@ -0,0 +1,399 @@
+#define _GNU_SOURCE 1
+
+#include <dlfcn.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// LAPACK through its Fortran interface (LP64 integers, column-major, hidden string lengths last),
+// so any provider works without LAPACKE headers
+typedef int lapack_int;
+void sgetrf_(const lapack_int* m, const lapack_int* n, float* a, const lapack_int* lda, lapack_int* ipiv, lapack_int* info);
+void dgetrf_(const lapack_int* m, const lapack_int* n, double* a, const lapack_int* lda, lapack_int* ipiv, lapack_int* info);
+void spotrf_(const char* uplo, const lapack_int* n, float* a, const lapack_int* lda, lapack_int* info, size_t uplo_len);
+void dpotrf_(const char* uplo, const lapack_int* n, double* a, const lapack_int* lda, lapack_int* info, size_t uplo_len);
+void sgeqrf_(const lapack_int* m, const lapack_int* n, float* a, const lapack_int* lda, float* tau,
+             float* work, const lapack_int* lwork, lapack_int* info);
+void dgeqrf_(const lapack_int* m, const lapack_int* n, double* a, const lapack_int* lda, double* tau,
+             double* work, const lapack_int* lwork, lapack_int* info);
+void ssyevd_(const char* jobz, const char* uplo, const lapack_int* n, float* a, const lapack_int* lda, float* w,
+             float* work, const lapack_int* lwork, lapack_int* iwork, const lapack_int* liwork, lapack_int* info,
+             size_t jobz_len, size_t uplo_len);
+void dsyevd_(const char* jobz, const char* uplo, const lapack_int* n, double* a, const lapack_int* lda, double* w,
+             double* work, const lapack_int* lwork, lapack_int* iwork, const lapack_int* liwork, lapack_int* info,
+             size_t jobz_len, size_t uplo_len);
+void dgemm_(void); // only its address is taken, to find the BLAS library
+
+typedef enum { ROUTINE_GETRF, ROUTINE_POTRF, ROUTINE_GEQRF, ROUTINE_SYEVD, ROUTINE_COUNT } Routine;
+
+static const char* routine_names[ROUTINE_COUNT] = { "getrf", "potrf", "geqrf", "syevd" };
+
+static double now_sec(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Floating point operations of one call on an n x n matrix, from LAWN 41 (mults + adds).
+// syevd (jobz=V) is nominal: reduction to tridiagonal form (sytrd) plus applying its reflectors
+// to the eigenvectors (2n^3); the divide & conquer solver itself depends on deflation and is not counted.
+static double routine_flops(Routine r, double n) {
+  switch (r) {
+    case ROUTINE_GETRF: return 2.0 / 3.0 * n * n * n - 0.5 * n * n + 5.0 / 6.0 * n;
+    case ROUTINE_POTRF: return 1.0 / 3.0 * n * n * n + 0.5 * n * n + 1.0 / 6.0 * n;
+    case ROUTINE_GEQRF: return 4.0 / 3.0 * n * n * n + 2.0 * n * n + 14.0 / 3.0 * n;
+    case ROUTINE_SYEVD: return 4.0 / 3.0 * n * n * n + 3.5 * n * n - 17.0 / 6.0 * n - 11.0 + 2.0 * n * n * n;
+    default:            return 0.0;
+  }
+}
+
+// --- Inputs ---
+
+// The LCG of the BLAS benchmarks: value = ((x >> 8) & 0xFFFF) / 32768 - 1
+static void fill_lcg(double* M, size_t count, unsigned seed) {
+  uint32_t x = seed ? seed : 1u;
+  for (size_t i = 0; i < count; ++i) {
+    x = 1664525u * x + 1013904223u;
+    M[i] = (float)((x >> 8) & 0xFFFF) / 32768.0f - 1.0f;
+  }
+}
+
+// General matrix for getrf/geqrf, symmetric for syevd, and symmetric with n added to the
+// diagonal for potrf (diagonally dominant, hence positive definite)
+static void make_input(Routine r, double* M, int n) {
+  fill_lcg(M, (size_t)n * n, 42);
+  if (r == ROUTINE_GETRF || r == ROUTINE_GEQRF) return;
+  for (int j = 0; j < n; ++j)
+    for (int i = j + 1; i < n; ++i) M[(size_t)j * n + i] = M[(size_t)i * n + j];
+  if (r == ROUTINE_POTRF) {
+    for (int i = 0; i < n; ++i) M[(size_t)i * n + i] += n;
+  }
+}
+
+// --- Routines ---
+
+typedef struct Workspace {
+  int is_double;
+  int n;
+  void* pristine;   // input, copied into `a` before every call
+  void* a;
+  void* vec;        // tau (geqrf) or eigenvalues (syevd)
+  lapack_int* ipiv;
+  void* work;
+  lapack_int lwork;
+  lapack_int* iwork;
+  lapack_int liwork;
+} Workspace;
+
+static lapack_int call_routine(Routine r, Workspace* w, int query) {
+  const lapack_int n = w->n, lwork = query ? -1 : w->lwork, liwork = query ? -1 : w->liwork;
+  lapack_int info = 0;
+  double dq[1];
+  float sq[1];
+  lapack_int iq[1];
+  void* work = query ? (w->is_double ? (void*)dq : (void*)sq) : w->work;
+  lapack_int* iwork = query ? iq : w->iwork;
+  switch (r) {
+    case ROUTINE_GETRF:
+      if (w->is_double) dgetrf_(&n, &n, (double*)w->a, &n, w->ipiv, &info);
+      else              sgetrf_(&n, &n, (float*)w->a, &n, w->ipiv, &info);
+      break;
+    case ROUTINE_POTRF:
+      if (w->is_double) dpotrf_("L", &n, (double*)w->a, &n, &info, 1);
+      else              spotrf_("L", &n, (float*)w->a, &n, &info, 1);
+      break;
+    case ROUTINE_GEQRF:
+      if (w->is_double) dgeqrf_(&n, &n, (double*)w->a, &n, (double*)w->vec, (double*)work, &lwork, &info);
+      else              sgeqrf_(&n, &n, (float*)w->a, &n, (float*)w->vec, (float*)work, &lwork, &info);
+      break;
+    case ROUTINE_SYEVD:
+      if (w->is_double) dsyevd_("V", "L", &n, (double*)w->a, &n, (double*)w->vec, (double*)work, &lwork, iwork, &liwork, &info, 1, 1);
+      else              ssyevd_("V", "L", &n, (float*)w->a, &n, (float*)w->vec, (float*)work, &lwork, iwork, &liwork, &info, 1, 1);
+      break;
+    default:
+      break;
+  }
+  if (query && info == 0) {
+    w->lwork = (lapack_int)(w->is_double ? dq[0] : sq[0]) + 1;
+    w->liwork = r == ROUTINE_SYEVD ? iq[0] : 1;
+  }
+  return info;
+}
+
+static void free_workspace(Workspace* w) {
+  free(w->pristine); free(w->a); free(w->vec); free(w->ipiv); free(w->work); free(w->iwork);
+  memset(w, 0, sizeof *w);
+}
+
+static int setup_workspace(Routine r, Workspace* w, int n, int is_double) {
+  memset(w, 0, sizeof *w);
+  w->is_double = is_double;
+  w->n = n;
+  const size_t esz = is_double ? sizeof(double) : sizeof(float);
+  const size_t count = (size_t)n * n;
+  double* input = (double*)malloc(count * sizeof(double));
+  w->pristine = malloc(count * esz);
+  w->a = malloc(count * esz);
+  w->vec = malloc((size_t)n * esz);
+  w->ipiv = (lapack_int*)malloc((size_t)n * sizeof(lapack_int));
+  if (!input || !w->pristine || !w->a || !w->vec || !w->ipiv) {
+    free(input);
+    free_workspace(w);
+    return 1;
+  }
+  make_input(r, input, n);
+  if (is_double) memcpy(w->pristine, input, count * sizeof(double));
+  else for (size_t i = 0; i < count; ++i) ((float*)w->pristine)[i] = (float)input[i];
+  free(input);
+
+  // Optimal workspace as reported by the provider (blocked algorithms depend on it)
+  w->lwork = w->liwork = 1;
+  if ((r == ROUTINE_GEQRF || r == ROUTINE_SYEVD) && call_routine(r, w, 1) != 0) {
+    free_workspace(w);
+    return 1;
+  }
+  w->work = malloc((size_t)w->lwork * esz);
+  w->iwork = (lapack_int*)malloc((size_t)w->liwork * sizeof(lapack_int));
+  if (!w->work || !w->iwork) {
+    free_workspace(w);
+    return 1;
+  }
+  return 0;
+}
+
+static int cmp_double(const void* a, const void* b) {
+  const double x = *(const double*)a, y = *(const double*)b;
+  return (x > y) - (x < y);
+}
+
+// Sum of the result (the factors, or the eigenvalues for syevd, whose eigenvectors are only unique up to sign)
+static double result_checksum(Routine r, const Workspace* w) {
+  const size_t count = r == ROUTINE_SYEVD ? (size_t)w->n : (size_t)w->n * w->n;
+  const void* p = r == ROUTINE_SYEVD ? w->vec : w->a;
+  double s = 0.0;
+  for (size_t i = 0; i < count; ++i) s += w->is_double ? ((const double*)p)[i] : ((const float*)p)[i];
+  return s;
+}
+
+// --- Provider identification ---
+
+// Minimal JSON escaper for strings we include in the engine JSON
+static void json_escape_str(const char* in, char* out, size_t out_len) {
+  size_t j = 0;
+  for (size_t i = 0; in[i] != '\0' && j + 6 < out_len; ++i) {
+    unsigned char c = (unsigned char)in[i];
+    if (c == '"' || c == '\\') { out[j++] = '\\'; out[j++] = (char)c; }
+    else if (c < 0x20) j += (size_t)snprintf(out + j, out_len - j, "\\u%04x", c);
+    else out[j++] = (char)c;
+  }
+  out[j] = '\0';
+}
+
+// The shared object defining `fn` (e.g. dgetrf_) and a handle on it (RTLD_DEFAULT if unknown; dlclose() otherwise)
+static void* provider_of(void* fn, const char** so_path) {
+  Dl_info info;
+  *so_path = "unknown";
+  if (dladdr(fn, &info) && info.dli_fname) {
+    *so_path = info.dli_fname;
+    void* h = dlopen(info.dli_fname, RTLD_NOLOAD | RTLD_LAZY);
+    if (h) return h;
+  }
+  return RTLD_DEFAULT;
+}
+
+// Like blas_get_engine_info() of blas-c: the library providing dgetrf_, identified by its exported symbols
+static void engine_info(char* buf, size_t len) {
+  const char* so_path;
+  void* provider = provider_of((void*)dgetrf_, &so_path);
+  const char* blas_path;
+  void* blas = provider_of((void*)dgemm_, &blas_path);
+
+  char name[32] = "LAPACK", version[256] = "";
+  typedef const char* (*str_fn)(void);
+  typedef char* (*flame_ver_fn)(void);               // FLA_Get_AOCL_Version()
+  typedef void (*mkl_get_ver_fn)(char*, int);        // mkl_get_version_string()
+  typedef void (*ilaver_fn)(lapack_int*, lapack_int*, lapack_int*);
+  flame_ver_fn flame_ver = (flame_ver_fn)dlsym(provider, "FLA_Get_AOCL_Version");
+  str_fn openblas_cfg = (str_fn)dlsym(provider, "openblas_get_config");
+  mkl_get_ver_fn mkl_ver = (mkl_get_ver_fn)dlsym(RTLD_DEFAULT, "mkl_get_version_string");
+  if (flame_ver || dlsym(provider, "FLA_Init")) {
+    snprintf(name, sizeof name, "libFLAME");
+    if (flame_ver) snprintf(version, sizeof version, "%s", flame_ver());
+  } else if (openblas_cfg) {
+    snprintf(name, sizeof name, "OpenBLAS");
+    snprintf(version, sizeof version, "%s", openblas_cfg());
+  } else if (mkl_ver) {
+    snprintf(name, sizeof name, "MKL");
+    mkl_ver(version, (int)sizeof version);
+  }
+
+  // LAPACK API level the provider implements (ilaver is part of LAPACK itself)
+  char api[32] = "unknown";
+  ilaver_fn ilaver = (ilaver_fn)dlsym(provider, "ilaver_");
+  if (!ilaver) ilaver = (ilaver_fn)dlsym(RTLD_DEFAULT, "ilaver_");
+  if (ilaver) {
+    lapack_int major = 0, minor = 0, patch = 0;
+    ilaver(&major, &minor, &patch);
+    snprintf(api, sizeof api, "%d.%d.%d", major, minor, patch);
+  }
+
+  char version_esc[512], so_esc[512], blas_esc[512];
+  json_escape_str(version[0] ? version : "unknown", version_esc, sizeof version_esc);
+  json_escape_str(so_path, so_esc, sizeof so_esc);
+  json_escape_str(blas_path, blas_esc, sizeof blas_esc);
+  snprintf(buf, len, "{\"name\":\"%s\",\"version\":\"%s\",\"lapack_version\":\"%s\",\"library\":\"%s\",\"blas_library\":\"%s\"}",
+           name, version_esc, api, so_esc, blas_esc);
+  if (provider != RTLD_DEFAULT) dlclose(provider);
+  if (blas != RTLD_DEFAULT) dlclose(blas);
+}
+
+// --- Benchmark ---
+
+// Times `repeats` calls (after one untimed warmup call), each on a fresh copy of the input;
+// prints one result object and returns non-zero if the routine failed
+static int run_one(const char* engine, Routine r, int n, int is_double, int repeats) {
+  const char prefix = is_double ? 'd' : 's';
+  printf("  {\"engine\": %s,\n   \"input\": {\"routine\":\"%c%s\",\"precision\":\"%c\",\"N\":%d,\"repeats\":%d},\n",
+         engine, prefix, routine_names[r], prefix, n, repeats);
+
+  Workspace w;
+  if (setup_workspace(r, &w, n, is_double) != 0) {
+    printf("   \"error\": \"allocation or workspace query failed\"}");
+    return 2;
+  }
+  const size_t bytes = (size_t)n * n * (is_double ? sizeof(double) : sizeof(float));
+  double* samples = (double*)malloc((size_t)repeats * sizeof(double));
+  lapack_int info = 0;
+  for (int i = -1; i < repeats && info == 0 && samples; ++i) {
+    memcpy(w.a, w.pristine, bytes);
+    const double t0 = now_sec();
+    info = call_routine(r, &w, 0);
+    const double t1 = now_sec();
+    if (i >= 0) samples[i] = t1 - t0;
+  }
+  if (!samples || info != 0) {
+    printf("   \"error\": \"%s\", \"info\": %d}", samples ? "routine failed" : "allocation failed", (int)info);
+    free(samples);
+    free_workspace(&w);
+    return 3;
+  }
+
+  double total = 0.0;
+  for (int i = 0; i < repeats; ++i) total += samples[i];
+  qsort(samples, (size_t)repeats, sizeof(double), cmp_double);
+  const double median = repeats % 2 ? samples[repeats / 2] : 0.5 * (samples[repeats / 2 - 1] + samples[repeats / 2]);
+  const double flops = routine_flops(r, n);
+  printf("   \"output\": {\"time_sec\": %.6f, \"gflops\": %.2f, \"flops_per_call\": %.0f, \"info\": %d, \"checksum\": %.6f,\n"
+         "              \"timing\": {\"min_sec\": %.6f, \"median_sec\": %.6f, \"gflops_best\": %.2f, \"gflops_median\": %.2f}}}",
+         total, flops * repeats / total * 1e-9, flops, (int)info, result_checksum(r, &w),
+         samples[0], median, flops / samples[0] * 1e-9, flops / median * 1e-9);
+  free(samples);
+  free_workspace(&w);
+  return 0;
+}
+
+static int parse_sizes(const char* s, int** sizes) {
+  int count = 1;
+  for (const char* p = s; *p; ++p) count += *p == ',';
+  *sizes = (int*)malloc((size_t)count * sizeof(int));
+  if (!*sizes) return 0;
+  int n = 0;
+  for (char* end; *s; s = *end == ',' ? end + 1 : end) {
+    const long v = strtol(s, &end, 10);
+    if (end == s || v <= 0 || (*end != ',' && *end != '\0')) {
+      free(*sizes);
+      *sizes = NULL;
+      return 0;
+    }
+    (*sizes)[n++] = (int)v;
+  }
+  return n;
+}
+
+static int parse_routines(const char* s, int* selected) {
+  memset(selected, 0, ROUTINE_COUNT * sizeof(int));
+  while (*s) {
+    const size_t len = strcspn(s, ",");
+    int found = 0;
+    for (int r = 0; r < ROUTINE_COUNT; ++r) {
+      if (strlen(routine_names[r]) == len && strncmp(s, routine_names[r], len) == 0) selected[r] = found = 1;
+    }
+    if (!found) return 0;
+    s += len + (s[len] == ',');
+  }
+  return 1;
+}
+
+static const char* opt_value(const char* arg, const char* name) {
+  const size_t len = strlen(name);
+  if (strncmp(arg, "--", 2) != 0 || strncmp(arg + 2, name, len) != 0 || arg[2 + len] != '=') return NULL;
+  return arg + 3 + len;
+}
+
+static void usage(const char* prog) {
+  fprintf(stderr, "Usage: %s [options] [N] [repeats]\n", prog);
+  fprintf(stderr, "       %s [options] --sizes=N,... [repeats]\n", prog);
+  fprintf(stderr, "  --precision=s|d         element type (default: d)\n");
+  fprintf(stderr, "  --routines=R,...        any of getrf,potrf,geqrf,syevd (default: all)\n");
+  fprintf(stderr, "  --sizes=N,...           matrix sizes to run instead of N; a single positional is then repeats\n");
+}
+
+int main(int argc, char** argv) {
+  int pos[2] = { 1024, 5 };
+  int npos = 0;
+  int is_double = 1;
+  int selected[ROUTINE_COUNT] = { 1, 1, 1, 1 };
+  int* sizes = NULL;
+  int nsizes = 0;
+  for (int i = 1; i < argc; ++i) {
+    const char* v;
+    int ok = 1;
+    if ((v = opt_value(argv[i], "precision"))) ok = (is_double = strcmp(v, "d") == 0) || strcmp(v, "s") == 0;
+    else if ((v = opt_value(argv[i], "routines"))) ok = parse_routines(v, selected);
+    else if ((v = opt_value(argv[i], "sizes"))) { free(sizes); ok = (nsizes = parse_sizes(v, &sizes)) > 0; }
+    else if (argv[i][0] == '-' && argv[i][1] == '-') ok = 0;
+    else if (npos < 2) pos[npos++] = atoi(argv[i]);
+    if (!ok) {
+      fprintf(stderr, "Invalid option: %s\n", argv[i]);
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  // With --sizes there is no N, so a lone positional is the repeat count
+  if (nsizes > 0 && npos == 2) {
+    fprintf(stderr, "N and --sizes are exclusive\n");
+    usage(argv[0]);
+    free(sizes);
+    return 1;
+  }
+  const int repeats = nsizes > 0 && npos == 1 ? pos[0] : pos[1];
+  if ((nsizes == 0 && pos[0] <= 0) || repeats <= 0) {
+    usage(argv[0]);
+    return 1;
+  }
+  if (nsizes == 0) {
+    sizes = &pos[0];
+    nsizes = 1;
+  }
+
+  char engine[2048];
+  engine_info(engine, sizeof engine);
+
+  // One result per routine and size, routines in the order getrf, potrf, geqrf, syevd
+  int rc = 0, nitems = 0;
+  printf("[\n");
+  for (int r = 0; r < ROUTINE_COUNT; ++r) {
+    if (!selected[r]) continue;
+    for (int s = 0; s < nsizes; ++s) {
+      if (nitems++ > 0) printf(",\n");
+      const int e = run_one(engine, (Routine)r, sizes[s], is_double, repeats);
+      if (rc == 0) rc = e;
+      fflush(stdout);
+    }
+  }
+  printf("\n]\n");
+  if (sizes != &pos[0]) free(sizes);
+  return rc;
+}
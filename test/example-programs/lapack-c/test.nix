@@ -0,0 +1,27 @@
+{ stdenv, lib, lapack-test, n ? 1024, iterations ? 3,
+  sizes ? [],       # Run these sizes instead of n
+  extraArgs ? [],   # Further lapack-test-c options, e.g. [ "--precision=s" "--routines=getrf,potrf" ]
+}:
+let
+    args = lib.escapeShellArgs (extraArgs
+        ++ lib.optional (sizes != []) "--sizes=${lib.concatMapStringsSep "," toString sizes}"
+        ++ lib.optional (sizes == []) (toString n) ++ [ (toString iterations) ]);
+in
+stdenv.mkDerivation {
+  name = "lapack-test-result";
+  version = "1.0.0";
+
+  src = ./.;
+  buildInputs = [ lapack-test ];
+
+  buildPhase = ''
+    set +e
+    ${lapack-test}/bin/lapack-test-c ${args} | tee result.json
+    set -e
+  '';
+
+  installPhase = ''
+    mkdir -p $out/lib
+    cp *.json $out/lib
+  '';
+}
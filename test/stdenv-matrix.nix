@@ -0,0 +1,114 @@
+# Benchmark matrix for the stdenvs of helper/stdenvs.nix
+# See documentation at ../docu/stdenvs.adoc
+#
+# Builds the blas-c harness (and the BLAS provider it links) with every stdenv for every `amdZenVersion`,
+# runs it through example-programs/blas-c/test.nix and merges the result.json files into one table.
+# Build one cell at a time, so the runs don't compete for the CPU:
+#   nix-build --max-jobs 1 --cores 0 ./test/stdenv-matrix.nix && cat result/lib/comparison.adoc
+{
+    importablePkgsDelegate ? <nixpkgs>,
+    unoptimizedPkgs ? (import importablePkgsDelegate {}),
+    lib ? unoptimizedPkgs.lib,
+    amdZenVersions ? [ 2 ],
+    stdenvNames ? [ "upstream" "reallySafeTweaks" "safeTweaks" "withLto" "withAggressiveFastMath" "withPgo" "withTargetClones" ],
+    providers ? [ "plain" "openblas" "amd-blis" ], # plain: the harness' own kernels, no BLAS library
+    # The providers are not rebuilt with these stdenvs but linked from the cache (`upstream`) instead
+    providerStdenvExclusions ? [ "withLto" ], # See overlays/library/blas-lapack: never LTO for BLIS
+    m ? 2048, n ? 2048, iterations ? 10,
+    extraArgs ? [], # Further blas-test-c options for every cell, e.g. [ "--target-ci=0.02" ]
+}:
+let
+    pkgs = unoptimizedPkgs;
+
+    stdenvsFor = amdZenVersion: import ../helper/stdenvs.nix {
+        baseStdenv = pkgs.gcc15Stdenv; # Same as in zen-optimized-pkgs.nix
+        inherit importablePkgsDelegate unoptimizedPkgs amdZenVersion; };
+
+    # The provider `name` built with `stdenvName`, wrapped into `blas` so each one offers libcblas and cblas.pc.
+    # With `upstream` it is the package from the cache, as is (runtime CPU dispatch).
+    providerFor = { name, stdenvName, stdenv, amdZenVersion }:
+        let
+            rebuilt = stdenvName != "upstream";
+            provider = {
+                openblas = if rebuilt
+                    then pkgs.openblas.override { inherit stdenv; target = "ZEN"; dynamicArch = false; enableAVX512 = amdZenVersion > 4; }
+                    else pkgs.openblas;
+                amd-blis = if rebuilt
+                    then pkgs.amd-blis.override { inherit stdenv; withArchitecture = "zen${toString amdZenVersion}"; }
+                    else pkgs.amd-blis;
+            }.${name};
+        in if name == "plain" then null else pkgs.blas.override { blasProvider = provider; };
+
+    # Stdenvs that wrap a whole build around one of the others; the table relates them to that one, too
+    baseStdenvOf = { withPgo = "safeTweaks"; withTargetClones = "safeTweaks"; };
+
+    cellFor = amdZenVersion: stdenvName: providerName:
+        let
+            stdenvs = stdenvsFor amdZenVersion;
+            providerStdenv = if builtins.elem stdenvName providerStdenvExclusions then "upstream" else stdenvName;
+            # The harness and its provider, both built with `stdenv` (or the cache for `providerStdenv` = upstream)
+            harnessWith = stdenv: pkgs.callPackage ./example-programs/blas-c {
+                inherit stdenv;
+                blas = providerFor {
+                    name = providerName;
+                    stdenvName = providerStdenv;
+                    stdenv = if providerStdenv == "upstream" then stdenvs.upstream else stdenv;
+                    inherit amdZenVersion; };
+            };
+            harness = if stdenvName == "withPgo"
+                then (stdenvs.withPgo {
+                    package = harnessWith;
+                    # A smaller run of the benchmarked operation trains both the harness and the provider it links
+                    training = instrumented: "${instrumented}/bin/blas-test-c 512 512 10 >/dev/null";
+                }).optimized
+                else harnessWith stdenvs.${stdenvName};
+            run = pkgs.callPackage ./example-programs/blas-c/test.nix { blas-test = harness; inherit m n iterations extraArgs; };
+            result = builtins.fromJSON (builtins.readFile "${run}/lib/result.json"); # Json was created by executing program
+            output = result.output or {};
+        in {
+            amd_zen_version = amdZenVersion;
+            stdenv = stdenvName;
+            provider = providerName;
+            provider_stdenv = if providerName == "plain" then null else providerStdenv;
+            engine = result.engine.name or null;
+            error = result.error or null;
+            time_sec = output.time_sec or null;
+            # The median call is less sensitive to a stray slow run than the mean behind `gflops`
+            gflops = output.timing.gflops_median or output.gflops or null;
+        };
+
+    cells = lib.concatMap (zen: lib.concatMap (se: map (cellFor zen se) providers) stdenvNames) amdZenVersions;
+
+    gflopsOf = stdenvName: cell: (lib.findFirst
+        (c: c.stdenv == stdenvName && c.provider == cell.provider && c.amd_zen_version == cell.amd_zen_version)
+        { gflops = null; } cells).gflops;
+    ratio = a: b: if a == null || b == null || b == 0 then null else a / b;
+
+    rows = map (cell: cell // {
+        speedup_vs_upstream = ratio cell.gflops (gflopsOf "upstream" cell);
+    } // lib.optionalAttrs (baseStdenvOf ? ${cell.stdenv}) {
+        base_stdenv = baseStdenvOf.${cell.stdenv};
+        speedup_vs_base = ratio cell.gflops (gflopsOf baseStdenvOf.${cell.stdenv} cell);
+    }) cells;
+
+    cellText = v: if v == null then "-" else toString v;
+    table = lib.concatLines ([
+        ".blas-c SGEMM M=N=${toString m}, K=${toString n}, ${toString iterations} repeats: GFLOPS and speedup relative to `upstream`"
+        ''[cols="1,2,2,2,2,1,1,2",options="header"]''
+        "|==="
+        "|Zen |stdenv |provider |provider stdenv |engine |GFLOPS |speedup |vs. base stdenv"
+    ] ++ map (r: lib.concatMapStrings (v: "|${v} ") [
+        (toString r.amd_zen_version) r.stdenv r.provider (cellText r.provider_stdenv) (cellText r.engine) (cellText r.gflops)
+        (if r.error != null then "error: ${r.error}" else cellText r.speedup_vs_upstream)
+        (if r ? base_stdenv then "${cellText r.speedup_vs_base} (${r.base_stdenv})" else "-")
+    ]) rows ++ [ "|===" ]);
+in pkgs.runCommand "blas-stdenv-matrix" {
+    comparisonJson = builtins.toJSON rows;
+    comparisonAdoc = table;
+    passAsFile = [ "comparisonJson" "comparisonAdoc" ];
+    passthru = { inherit rows; };
+} ''
+    mkdir -p $out/lib
+    cp "$comparisonJsonPath" $out/lib/comparison.json
+    cp "$comparisonAdocPath" $out/lib/comparison.adoc
+''
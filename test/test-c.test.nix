@@ -25,6 +25,25 @@ in {
             expr = buildInfoJson.compiler.fast_math;
             expected = false; # TODO: Add a test where we force that on
         };
+        "test glibc-hwcaps probe finds the BLAS library" = {
+            expr = let
+                probeProgram = pkgsTuned.callPackage ./example-programs/buildinfo-c { hwcapsProbe = { "libcblas.so.3" = pkgsTuned.blas; }; };
+                probeJson = builtins.fromJSON (builtins.readFile "${probeProgram}/lib/buildinfo.json");
+            in map (p: { inherit (p) library; found = p.path != null; }) probeJson.glibc_hwcaps.probed;
+            expected = [ { library = "libcblas.so.3"; found = true; } ];
+        };
+        "test target_clones build reports its clones" = {
+            expr = let
+                stdenvs = import ../helper/stdenvs.nix { inherit importablePkgsDelegate; amdZenVersion = 2; };
+                clonesProgram = pkgsTuned.callPackage ./example-programs/buildinfo-c { stdenv = stdenvs.withTargetClones; };
+                clonesJson = builtins.fromJSON (builtins.readFile "${clonesProgram}/lib/buildinfo.json");
+            in {
+                inherit (clonesJson.target_clones) archs;
+                # Which clone depends on the build host, but the probe must find it by name
+                resolved = clonesJson.target_clones.selected != "unknown";
+            };
+            expected = { archs = [ "znver5" "znver4" "znver3" ]; resolved = true; };
+        };
         "test avx and sse" = {
             expr = {
                 sse = buildInfoJson.compiler.sse or false;
@@ -80,6 +99,181 @@ in {
                 expected = "BLIS";
             };
 
+            "test plain C on CPU" = {
+                expr = let
+                    testProgram = pkgsTuned.callPackage ./example-programs/blas-c { isCpu = true; blas = null; };
+                    testExecution = pkgsTuned.callPackage ./example-programs/blas-c/test.nix { blas-test = testProgram; m = 2048; n = 2048; iterations = 10; };
+                    testResult = (builtins.fromJSON (builtins.readFile "${testExecution}/lib/result.json"));
+                in testResult.engine.name;
+                expected = "PlainC";
+            };
+
+            "test plain C timing samples" = {
+                expr = let
+                    testProgram = pkgsTuned.callPackage ./example-programs/blas-c { isCpu = true; blas = null; };
+                    testExecution = pkgsTuned.callPackage ./example-programs/blas-c/test.nix { blas-test = testProgram; m = 512; n = 512; iterations = 10; extraArgs = [ "--warmup=2" ]; };
+                    testResult = (builtins.fromJSON (builtins.readFile "${testExecution}/lib/result.json"));
+                in { inherit (testResult.output.timing) warmup samples; };
+                expected = { warmup = 2; samples = 10; };
+            };
+
+            "test backend plugins in one run" = {
+                expr = let
+                    testProgram = pkgsTuned.callPackage ./example-programs/blas-c { isCpu = true; };
+                    testExecution = pkgsTuned.callPackage ./example-programs/blas-c/test.nix {
+                        blas-test = testProgram; m = 512; n = 512; iterations = 10;
+                        extraArgs = [ "--plugin=${testProgram}/lib/blas-backends/cblas.so" "--plugin=${testProgram}/lib/blas-backends/plain.so" ];
+                    };
+                    testResult = (builtins.fromJSON (builtins.readFile "${testExecution}/lib/result.json"));
+                in map (r: r.engine.name) testResult;
+                expected = [ "BLIS" "PlainC" ];
+            };
+
+            "test huge page allocation is recorded" = {
+                expr = let
+                    testProgram = pkgsTuned.callPackage ./example-programs/blas-c { isCpu = true; };
+                    testExecution = pkgsTuned.callPackage ./example-programs/blas-c/test.nix {
+                        blas-test = testProgram; m = 2048; n = 2048; iterations = 10;
+                        extraArgs = [ "--pages=thp" "--first-touch=parallel" ];
+                    };
+                    testResult = (builtins.fromJSON (builtins.readFile "${testExecution}/lib/result.json"));
+                in { inherit (testResult.input.allocation) pages first_touch; };
+                expected = { pages = "thp"; first_touch = "parallel"; };
+            };
+
+            "test batched small GEMMs" = {
+                expr = let
+                    testProgram = pkgsTuned.callPackage ./example-programs/blas-c { isCpu = true; };
+                    testExecution = pkgsTuned.callPackage ./example-programs/blas-c/test.nix {
+                        blas-test = testProgram; m = 16; n = 16; iterations = 10;
+                        extraArgs = [ "--batch=1000" ];
+                    };
+                    testResult = (builtins.fromJSON (builtins.readFile "${testExecution}/lib/result.json"));
+                in { inherit (testResult.input) batch; measured = testResult.output.batch.matrices_per_sec > 0; };
+                expected = { batch = 1000; measured = true; };
+            };
+
+            "test fixed-size kernels against BLIS" = {
+                expr = let
+                    testProgram = pkgsTuned.callPackage ./example-programs/blas-c { isCpu = true; };
+                    testExecution = pkgsTuned.callPackage ./example-programs/blas-c/test.nix {
+                        blas-test = testProgram; m = 16; n = 16; iterations = 10;
+                        extraArgs = [ "--plugin=${testProgram}/lib/blas-backends/plain.so" "--plugin=${testProgram}/lib/blas-backends/cblas.so"
+                                      "--batch=1000" "--shapes=3x3x3,8x8x8,16x16x16,32x32x32" ];
+                    };
+                    testResult = (builtins.fromJSON (builtins.readFile "${testExecution}/lib/result.json"));
+                in {
+                    engines = map (r: r.engine.name) testResult;
+                    fixedSizes = (builtins.head testResult).engine.fixed_sizes;
+                };
+                expected = {
+                    engines = [ "PlainC" "PlainC" "PlainC" "PlainC" "BLIS" "BLIS" "BLIS" "BLIS" ];
+                    fixedSizes = [ 3 4 8 16 32 ];
+                };
+            };
+
+            "test memory-bound level-1/level-2 kernels with AMD BLIS on CPU" = {
+                expr = let
+                    testProgram = pkgsTuned.callPackage ./example-programs/blas-c { isCpu = true; };
+                    testExecution = pkgsTuned.callPackage ./example-programs/blas-c/test.nix {
+                        blas-test = testProgram; m = 2048; n = 2048; iterations = 10;
+                        extraArgs = [ "--level=1,2" "--working-sets=32K,64M" ];
+                    };
+                    testResult = (builtins.fromJSON (builtins.readFile "${testExecution}/lib/result.json"));
+                in {
+                    ops = map (r: r.input.op) testResult;
+                    allMeasured = builtins.all (r: r ? output && r.output.stream.triad_gbs > 0) testResult;
+                };
+                expected = {
+                    ops = [ "saxpy" "saxpy" "sdot" "sdot" "snrm2" "snrm2" "sgemv" "sgemv" "sger" "sger" "strsv" "strsv" ];
+                    allMeasured = true;
+                };
+            };
+
+            "test thread scaling per binding policy with AMD BLIS on CPU" = {
+                expr = let
+                    testProgram = pkgsTuned.callPackage ./example-programs/blas-c { isCpu = true; };
+                    testExecution = pkgsTuned.callPackage ./example-programs/blas-c/test.nix {
+                        blas-test = testProgram; m = 512; n = 512; iterations = 5;
+                        extraArgs = [ "--thread-sweep" "--bind=close,spread,ccx" ];
+                    };
+                    testResult = (builtins.fromJSON (builtins.readFile "${testExecution}/lib/result.json"));
+                in {
+                    binds = map (r: r.engine.bind) testResult;
+                    threadApis = map (r: r.engine.thread_api) testResult;
+                    startsSingleThreaded = builtins.all (r: (builtins.head r.output.scaling).threads == 1) testResult;
+                };
+                expected = {
+                    binds = [ "close" "spread" "ccx" ];
+                    threadApis = [ "bli_thread_set_num_threads" "bli_thread_set_num_threads" "bli_thread_set_num_threads" ];
+                    startsSingleThreaded = true;
+                };
+            };
+
+            "test concurrent tenants with AMD BLIS on CPU" = {
+                expr = let
+                    testProgram = pkgsTuned.callPackage ./example-programs/blas-c { isCpu = true; };
+                    testExecution = pkgsTuned.callPackage ./example-programs/blas-c/test.nix {
+                        blas-test = testProgram; m = 512; n = 512; iterations = 10;
+                        extraArgs = [ "--tenants=3" "--tenant-threads=1" ];
+                    };
+                    testResult = (builtins.fromJSON (builtins.readFile "${testExecution}/lib/result.json"));
+                in {
+                    inherit (testResult.input) tenants threads_per_tenant;
+                    sameChecksums = builtins.length (lib.unique (map (t: t.checksum) testResult.output.tenants)) == 1;
+                };
+                expected = { tenants = 3; threads_per_tenant = 1; sameChecksums = true; };
+            };
+
+            "test many tenants on huge pages with AMD BLIS on CPU" = {
+                expr = let
+                    testProgram = pkgsTuned.callPackage ./example-programs/blas-c { isCpu = true; };
+                    testExecution = pkgsTuned.callPackage ./example-programs/blas-c/test.nix {
+                        blas-test = testProgram; m = 64; n = 64; iterations = 5;
+                        # 3 matrices per tenant, all mmap'ed: more live allocations than a small fixed table holds
+                        extraArgs = [ "--tenants=16" "--tenant-threads=1" "--pages=thp" ];
+                    };
+                    testResult = (builtins.fromJSON (builtins.readFile "${testExecution}/lib/result.json"));
+                in {
+                    inherit (testResult.input) tenants;
+                    results = builtins.length testResult.output.tenants;
+                };
+                expected = { tenants = 16; results = 16; };
+            };
+
+            "test cold start phases with AMD BLIS on CPU" = {
+                expr = let
+                    testProgram = pkgsTuned.callPackage ./example-programs/blas-c { isCpu = true; };
+                    testExecution = pkgsTuned.callPackage ./example-programs/blas-c/test.nix {
+                        blas-test = testProgram; m = 512; n = 512; iterations = 5;
+                        extraArgs = [ "--cold-samples=3" ];
+                    };
+                    testResult = (builtins.fromJSON (builtins.readFile "${testExecution}/lib/result.json"));
+                in builtins.attrNames testResult.output.cold_start;
+                expected = [ "exec_to_main" "first_call" "init" "operands" "provider_load" "samples" "second_call" "steady_call" "time_to_first_result" ];
+            };
+
+            "test energy is reported only when readable" = {
+                expr = let
+                    testProgram = pkgsTuned.callPackage ./example-programs/blas-c { isCpu = true; };
+                    testExecution = pkgsTuned.callPackage ./example-programs/blas-c/test.nix { blas-test = testProgram; m = 1024; n = 1024; iterations = 10; };
+                    testResult = (builtins.fromJSON (builtins.readFile "${testExecution}/lib/result.json"));
+                in !(testResult.output ? energy) || testResult.output.energy.package_joules > 0;
+                expected = true;
+            };
+
+            "test shape sweep with AMD BLIS on CPU" = {
+                expr = let
+                    testProgram = pkgsTuned.callPackage ./example-programs/blas-c { isCpu = true; };
+                    testExecution = pkgsTuned.callPackage ./example-programs/blas-c/test.nix { blas-test = testProgram; m = 512; n = 512; iterations = 10; sweep = true; };
+                    testResult = (builtins.fromJSON (builtins.readFile "${testExecution}/lib/result.json"));
+                in {
+                    shapes = builtins.length testResult;
+                    allMeasured = builtins.all (r: r ? output) testResult;
+                };
+                expected = { shapes = 18; allMeasured = true; };
+            };
+
             "test AMD rocBLAS on GPU (hipcc)" = {
                 expr = let
                     testProgram = pkgsTuned.callPackage ./example-programs/blas-c { isCpu = false; rocblas = pkgsTuned.rocmPackages.rocblas; hipcc = pkgsTuned.rocmPackages.hipcc; clr = pkgsTuned.rocmPackages.clr; };
@@ -98,4 +292,41 @@ in {
                 expected = "rocBLAS";
             };
         };
+
+        "stdenv comparison" = {
+            "test stdenv matrix relates every cell to upstream" = {
+                expr = let
+                    matrix = import ./stdenv-matrix.nix { inherit importablePkgsDelegate lib;
+                        stdenvNames = [ "upstream" "safeTweaks" ]; providers = [ "plain" ]; m = 512; n = 512; iterations = 10; };
+                in map (r: { inherit (r) stdenv; hasSpeedup = r.speedup_vs_upstream != null; }) matrix.rows;
+                expected = [ { stdenv = "upstream"; hasSpeedup = true; } { stdenv = "safeTweaks"; hasSpeedup = true; } ];
+            };
+            "test PGO build is compared with its non-PGO base" = {
+                expr = let
+                    matrix = import ./stdenv-matrix.nix { inherit importablePkgsDelegate lib;
+                        stdenvNames = [ "upstream" "safeTweaks" "withPgo" ]; providers = [ "plain" ]; m = 512; n = 512; iterations = 10; };
+                    pgoRow = lib.findFirst (r: r.stdenv == "withPgo") {} matrix.rows;
+                in { base = pgoRow.base_stdenv or null; hasSpeedup = (pgoRow.speedup_vs_base or null) != null; };
+                expected = { base = "safeTweaks"; hasSpeedup = true; };
+            };
+        };
+
+        "LAPACK implementations" = {
+            "test AMD libFLAME factorizations on CPU" = {
+                expr = let
+                    testProgram = pkgsTuned.callPackage ./example-programs/lapack-c { };
+                    testExecution = pkgsTuned.callPackage ./example-programs/lapack-c/test.nix { lapack-test = testProgram; sizes = [ 256 1024 ]; iterations = 3; };
+                    testResult = (builtins.fromJSON (builtins.readFile "${testExecution}/lib/result.json"));
+                in {
+                    engine = (builtins.head testResult).engine.name;
+                    routines = map (r: r.input.routine) testResult;
+                    allSucceeded = builtins.all (r: (r.output.info or (-1)) == 0) testResult;
+                };
+                expected = {
+                    engine = "libFLAME";
+                    routines = [ "dgetrf" "dgetrf" "dpotrf" "dpotrf" "dgeqrf" "dgeqrf" "dsyevd" "dsyevd" ];
+                    allSucceeded = true;
+                };
+            };
+        };
 }
\ No newline at end of file
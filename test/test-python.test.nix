@@ -39,5 +39,21 @@ in {
             in testResult.engine.name;
             expected = "NumPy"; # We can't see what NumPy uses, sadly
         };
+        "test input matrices are generated outside the timed region" = {
+            expr = let
+                testProgram = pkgsTuned.callPackage ./example-programs/blas-python { };
+                testExecution = pkgsTuned.callPackage ./example-programs/blas-python/test.nix { blas-test = testProgram; m = 512; n = 512; iterations = 10; };
+                testResult = (builtins.fromJSON (builtins.readFile "${testExecution}/lib/result.json"));
+            in testResult.output ? setup_sec;
+            expected = true;
+        };
+        "test direct cblas_sgemm through ctypes" = {
+            expr = let
+                testProgram = pkgsTuned.callPackage ./example-programs/blas-python { };
+                testExecution = pkgsTuned.callPackage ./example-programs/blas-python/test.nix { blas-test = testProgram; m = 512; n = 512; iterations = 10; extraArgs = [ "--backend=cpu" "--mode=matmul,ctypes" ]; };
+                testResult = (builtins.fromJSON (builtins.readFile "${testExecution}/lib/result.json"));
+            in map (r: { mode = r.engine.mode; overhead = r.output ? call_overhead_sec; }) testResult;
+            expected = [ { mode = "matmul"; overhead = true; } { mode = "ctypes"; overhead = false; } ];
+        };
     };
 }
\ No newline at end of file
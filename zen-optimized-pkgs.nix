@@ -14,6 +14,7 @@
     isAggressiveFastMathEnabled ? false, # Will cause loss of precision and also some tests to fail (=> some tests will get disabled)
     optimizationParameter ? "-O3",
     basePythonPackage ? pkgs: pkgs.python3Minimal,
+    hwcapsZenVersions ? [], # e.g. [ 4 ]: hot shared libraries also built for these, in lib/glibc-hwcaps/ (see docu)
     noOptimizePkgs ? with unoptimizedPkgs; { inherit
 # end::header[]
         # CAUTION: Be careful what you add here. If it transitively pulls in stuff from unoptimizedPkgs.pkgs
@@ -82,6 +83,17 @@ let
         baseStdenv = unoptimizedPkgs.gcc15Stdenv; # TODO: Or pkgs.gcc_latest.stdenv? or pkgs.llvmPackages_latest.stdenv?
         inherit importablePkgsDelegate unoptimizedPkgs amdZenVersion optimizationParameter; };
 
+    # Further builds of hot shared libraries, picked by the dynamic loader at runtime (glibc-hwcaps):
+    # { "x86-64-v4" = { amdZenVersion = 4; stdenvs = ...; }; }
+    hwcaps = import ./helper/glibc-hwcaps.nix { inherit lib; };
+    hwcapsVariants = lib.listToAttrs (map (zen: lib.nameValuePair (hwcaps.levelOfZen zen) {
+        amdZenVersion = zen;
+        stdenvs = import ./helper/stdenvs.nix {
+            baseStdenv = unoptimizedPkgs.gcc15Stdenv;
+            inherit importablePkgsDelegate unoptimizedPkgs optimizationParameter;
+            amdZenVersion = zen; };
+    }) hwcapsZenVersions);
+
     # ---------------------------------------------
     # Overlay imports follow
 
@@ -89,12 +101,18 @@ let
     goOverlay = import ./overlays/compiler/go/default.nix { inherit optimizedPlatform unoptimizedPkgs isLtoEnabled; };
     haskellOverlay = import ./overlays/compiler/haskell/default.nix { inherit optimizedPlatform unoptimizedPkgs; };
     rustOverlay = import ./overlays/compiler/rust/default.nix { inherit optimizedPlatform unoptimizedPkgs isLtoEnabled; };
-    pythonOverlay = import ./overlays/interpreter/python/default.nix { inherit optimizedPlatform unoptimizedPkgs basePythonPackage isLtoEnabled isAggressiveFastMathEnabled; };
+    pythonOverlay = import ./overlays/interpreter/python/default.nix { inherit optimizedPlatform unoptimizedPkgs basePythonPackage isLtoEnabled isAggressiveFastMathEnabled hwcapsVariants; };
     rOverlay = import ./overlays/interpreter/r/default.nix { inherit optimizedPlatform unoptimizedPkgs; };
-    openBlasOverlay = import ./overlays/library/blas-lapack/default.nix { inherit optimizedPlatform unoptimizedPkgs stdenvs amdZenVersion; };
+    openBlasOverlay = import ./overlays/library/blas-lapack/default.nix { inherit optimizedPlatform unoptimizedPkgs stdenvs amdZenVersion hwcapsVariants; };
     # TODO: OpenMP ??
 
-in import importablePkgsDelegate rec {
+in
+# The loader tries the best level first: a variant at (or below) the level of amdZenVersion would win over lib/ itself
+assert lib.assertMsg (builtins.all (zen: hwcaps.levelNumberOfZen zen > hwcaps.levelNumberOfZen amdZenVersion) hwcapsZenVersions)
+    "hwcapsZenVersions: glibc-hwcaps only knows x86-64 levels; each version needs a level above ${hwcaps.levelOfZen amdZenVersion} (the one of amdZenVersion)";
+assert lib.assertMsg (lib.length (lib.attrNames hwcapsVariants) == lib.length hwcapsZenVersions)
+    "hwcapsZenVersions: at most one Zen version per x86-64 level";
+import importablePkgsDelegate rec {
     #inherit (unoptimizedPkgs) config;
     config.allowUnfree = true;
     localSystem = optimizedPlatform;